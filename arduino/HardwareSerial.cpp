@@ -51,47 +51,101 @@
 #endif
 #endif
 
-// Define constants and variables for buffering incoming serial data.  We're
-// using a ring buffer (I think), in which head is the index of the location
-// to which to write the next incoming character and tail is the index of the
-// location from which to read.
+// Define constants and variables for buffering incoming and outgoing serial
+// data.  We're using ring buffers, in which head is the index of the location
+// to which to write the next character and tail is the index of the location
+// from which to read.  Both sizes can be overridden on the command line; they
+// must be powers of two no larger than 256 so that the indices fit in a byte
+// and wrap around with a mask instead of a division.  One slot of each buffer
+// is always left empty to tell a full buffer from an empty one.
+#ifndef SERIAL_RX_BUFFER_SIZE
 #if (RAMEND < 1000)
-  #define SERIAL_BUFFER_SIZE 16
+  #define SERIAL_RX_BUFFER_SIZE 16
 #else
-  #define SERIAL_BUFFER_SIZE 64
+  #define SERIAL_RX_BUFFER_SIZE 128
 #endif
+#endif
+
+#ifndef SERIAL_TX_BUFFER_SIZE
+#if (RAMEND < 1000)
+  #define SERIAL_TX_BUFFER_SIZE 16
+#else
+  #define SERIAL_TX_BUFFER_SIZE 64
+#endif
+#endif
+
+#if (SERIAL_RX_BUFFER_SIZE > 256) || (SERIAL_RX_BUFFER_SIZE & (SERIAL_RX_BUFFER_SIZE - 1))
+  #error "SERIAL_RX_BUFFER_SIZE must be a power of two no larger than 256"
+#endif
+#if (SERIAL_TX_BUFFER_SIZE > 256) || (SERIAL_TX_BUFFER_SIZE & (SERIAL_TX_BUFFER_SIZE - 1))
+  #error "SERIAL_TX_BUFFER_SIZE must be a power of two no larger than 256"
+#endif
+
+// Number of strings in program memory that can be queued for transmission
+// (see write_P()).  Must be a power of two no larger than 256.
+#ifndef SERIAL_TX_FLASH_QUEUE_SIZE
+  #define SERIAL_TX_FLASH_QUEUE_SIZE 8
+#endif
+
+#if (SERIAL_TX_FLASH_QUEUE_SIZE > 256) || (SERIAL_TX_FLASH_QUEUE_SIZE & (SERIAL_TX_FLASH_QUEUE_SIZE - 1))
+  #error "SERIAL_TX_FLASH_QUEUE_SIZE must be a power of two no larger than 256"
+#endif
+
+#define SERIAL_RX_BUFFER_MASK (SERIAL_RX_BUFFER_SIZE - 1)
+#define SERIAL_TX_BUFFER_MASK (SERIAL_TX_BUFFER_SIZE - 1)
+#define SERIAL_TX_FLASH_QUEUE_MASK (SERIAL_TX_FLASH_QUEUE_SIZE - 1)
+
+struct rx_ring_buffer
+{
+  unsigned char buffer[SERIAL_RX_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+};
+
+// A string in program memory waiting to be sent.  It goes out once the
+// transmit ring's tail reaches 'position', i.e. after everything that was
+// written to the ring before it and before anything written after it.
+struct tx_flash_segment
+{
+  const char * volatile data;
+  volatile size_t remaining;
+  volatile uint8_t position;
+};
 
-struct ring_buffer
+struct tx_ring_buffer
 {
-  unsigned char buffer[SERIAL_BUFFER_SIZE];
-  volatile unsigned int head;
-  volatile unsigned int tail;
+  unsigned char buffer[SERIAL_TX_BUFFER_SIZE];
+  volatile uint8_t head;
+  volatile uint8_t tail;
+  tx_flash_segment flash[SERIAL_TX_FLASH_QUEUE_SIZE];
+  volatile uint8_t flash_head;
+  volatile uint8_t flash_tail;
 };
 
 #if defined(USBCON)
-  ring_buffer rx_buffer = { { 0 }, 0, 0};
-  ring_buffer tx_buffer = { { 0 }, 0, 0};
+  rx_ring_buffer rx_buffer = { { 0 }, 0, 0};
+  tx_ring_buffer tx_buffer = { { 0 }, 0, 0, { }, 0, 0};
 #endif
 #if defined(UBRRH) || defined(UBRR0H)
-  ring_buffer rx_buffer  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer  =  { { 0 }, 0, 0, { }, 0, 0 };
 #endif
 #if defined(UBRR1H)
-  ring_buffer rx_buffer1  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer1  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer1  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer1  =  { { 0 }, 0, 0, { }, 0, 0 };
 #endif
 #if defined(UBRR2H)
-  ring_buffer rx_buffer2  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer2  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer2  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer2  =  { { 0 }, 0, 0, { }, 0, 0 };
 #endif
 #if defined(UBRR3H)
-  ring_buffer rx_buffer3  =  { { 0 }, 0, 0 };
-  ring_buffer tx_buffer3  =  { { 0 }, 0, 0 };
+  rx_ring_buffer rx_buffer3  =  { { 0 }, 0, 0 };
+  tx_ring_buffer tx_buffer3  =  { { 0 }, 0, 0, { }, 0, 0 };
 #endif
 
-inline void store_char(unsigned char c, ring_buffer *buffer)
+inline void store_char(unsigned char c, rx_ring_buffer *buffer)
 {
-  int i = (unsigned int)(buffer->head + 1) % SERIAL_BUFFER_SIZE;
+  uint8_t i = (uint8_t)(buffer->head + 1) & SERIAL_RX_BUFFER_MASK;
 
   // if we should be storing the received character into the location
   // just before the tail (meaning that the head would advance to the
@@ -103,6 +157,31 @@ inline void store_char(unsigned char c, ring_buffer *buffer)
   }
 }
 
+// Fetch the next character to transmit from the buffer into *c.  Queued
+// program memory strings are read straight from flash when their turn comes.
+// Returns false if there is nothing left to send.
+inline bool next_tx_char(tx_ring_buffer *buffer, unsigned char *c)
+{
+  if (buffer->flash_head != buffer->flash_tail) {
+    tx_flash_segment *segment = &buffer->flash[buffer->flash_tail];
+    if (segment->position == buffer->tail) {
+      const char *data = segment->data;
+      *c = pgm_read_byte(data);
+      segment->data = data + 1;
+      if (--segment->remaining == 0) {
+        buffer->flash_tail = (uint8_t)(buffer->flash_tail + 1) & SERIAL_TX_FLASH_QUEUE_MASK;
+      }
+      return true;
+    }
+  }
+  if (buffer->head == buffer->tail) {
+    return false;
+  }
+  *c = buffer->buffer[buffer->tail];
+  buffer->tail = (uint8_t)(buffer->tail + 1) & SERIAL_TX_BUFFER_MASK;
+  return true;
+}
+
 #if !defined(USART0_RX_vect) && defined(USART1_RX_vect)
 // do nothing - on the 32u4 the first USART is USART1
 #else
@@ -220,7 +299,8 @@ ISR(USART0_UDRE_vect)
 ISR(USART_UDRE_vect)
 #endif
 {
-  if (tx_buffer.head == tx_buffer.tail) {
+  unsigned char c;
+  if (!next_tx_char(&tx_buffer, &c)) {
 	// Buffer empty, so disable interrupts
 #if defined(UCSR0B)
     cbi(UCSR0B, UDRIE0);
@@ -230,9 +310,6 @@ ISR(USART_UDRE_vect)
   }
   else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer.buffer[tx_buffer.tail];
-    tx_buffer.tail = (tx_buffer.tail + 1) % SERIAL_BUFFER_SIZE;
-	
   #if defined(UDR0)
     UDR0 = c;
   #elif defined(UDR)
@@ -248,15 +325,13 @@ ISR(USART_UDRE_vect)
 #ifdef USART1_UDRE_vect
 ISR(USART1_UDRE_vect)
 {
-  if (tx_buffer1.head == tx_buffer1.tail) {
+  unsigned char c;
+  if (!next_tx_char(&tx_buffer1, &c)) {
 	// Buffer empty, so disable interrupts
     cbi(UCSR1B, UDRIE1);
   }
   else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer1.buffer[tx_buffer1.tail];
-    tx_buffer1.tail = (tx_buffer1.tail + 1) % SERIAL_BUFFER_SIZE;
-	
     UDR1 = c;
   }
 }
@@ -265,15 +340,13 @@ ISR(USART1_UDRE_vect)
 #ifdef USART2_UDRE_vect
 ISR(USART2_UDRE_vect)
 {
-  if (tx_buffer2.head == tx_buffer2.tail) {
+  unsigned char c;
+  if (!next_tx_char(&tx_buffer2, &c)) {
 	// Buffer empty, so disable interrupts
     cbi(UCSR2B, UDRIE2);
   }
   else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer2.buffer[tx_buffer2.tail];
-    tx_buffer2.tail = (tx_buffer2.tail + 1) % SERIAL_BUFFER_SIZE;
-	
     UDR2 = c;
   }
 }
@@ -282,15 +355,13 @@ ISR(USART2_UDRE_vect)
 #ifdef USART3_UDRE_vect
 ISR(USART3_UDRE_vect)
 {
-  if (tx_buffer3.head == tx_buffer3.tail) {
+  unsigned char c;
+  if (!next_tx_char(&tx_buffer3, &c)) {
 	// Buffer empty, so disable interrupts
     cbi(UCSR3B, UDRIE3);
   }
   else {
     // There is more data in the output buffer. Send the next byte
-    unsigned char c = tx_buffer3.buffer[tx_buffer3.tail];
-    tx_buffer3.tail = (tx_buffer3.tail + 1) % SERIAL_BUFFER_SIZE;
-	
     UDR3 = c;
   }
 }
@@ -299,7 +370,7 @@ ISR(USART3_UDRE_vect)
 
 // Constructors ////////////////////////////////////////////////////////////////
 
-HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer,
+HardwareSerial::HardwareSerial(rx_ring_buffer *rx_buffer, tx_ring_buffer *tx_buffer,
   volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
   volatile uint8_t *ucsrc, volatile uint8_t *udr,
@@ -318,6 +389,7 @@ HardwareSerial::HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer,
   _rxcie = rxcie;
   _udrie = udrie;
   _u2x = u2x;
+  _rx_scanned = 0;
 }
 
 // Public Methods //////////////////////////////////////////////////////////////
@@ -414,7 +486,7 @@ try_again:
 void HardwareSerial::end()
 {
   // wait for transmission of outgoing data
-  while (_tx_buffer->head != _tx_buffer->tail)
+  while (_tx_buffer->head != _tx_buffer->tail || _tx_buffer->flash_head != _tx_buffer->flash_tail)
     ;
 
   cbi(*_ucsrb, _rxen);
@@ -424,11 +496,12 @@ void HardwareSerial::end()
   
   // clear any received data
   _rx_buffer->head = _rx_buffer->tail;
+  _rx_scanned = 0;
 }
 
 int HardwareSerial::available(void)
 {
-  return (unsigned int)(SERIAL_BUFFER_SIZE + _rx_buffer->head - _rx_buffer->tail) % SERIAL_BUFFER_SIZE;
+  return (uint8_t)(_rx_buffer->head - _rx_buffer->tail) & SERIAL_RX_BUFFER_MASK;
 }
 
 int HardwareSerial::peek(void)
@@ -447,11 +520,79 @@ int HardwareSerial::read(void)
     return -1;
   } else {
     unsigned char c = _rx_buffer->buffer[_rx_buffer->tail];
-    _rx_buffer->tail = (unsigned int)(_rx_buffer->tail + 1) % SERIAL_BUFFER_SIZE;
+    _rx_buffer->tail = (uint8_t)(_rx_buffer->tail + 1) & SERIAL_RX_BUFFER_MASK;
+    if (_rx_scanned) _rx_scanned--;
     return c;
   }
 }
 
+// Reverse buffer[first, last).
+static void reverse_bytes(unsigned char *buffer, unsigned int first, unsigned int last)
+{
+  while (first + 1 < last) {
+    unsigned char c = buffer[first];
+    buffer[first++] = buffer[--last];
+    buffer[last] = c;
+  }
+}
+
+// Look for a complete ('\n'-terminated) line in the receive buffer without
+// copying it out.  If there is one, *line is pointed at its first character
+// and its length (not counting the newline) is returned.  The line stays in
+// the receive buffer, so it is safe to use in place, until it is dropped with
+// discard(length + 1).  Returns -1 if no complete line has been received
+// yet, or -2 if the buffer filled up without a newline, in which case the
+// buffered characters are dropped.
+int HardwareSerial::peekLine(const char **line)
+{
+  uint8_t count = available();
+  uint8_t tail = _rx_buffer->tail;
+
+  // Resume the search where the previous call stopped.
+  while (_rx_scanned < count) {
+    if (_rx_buffer->buffer[(uint8_t)(tail + _rx_scanned) & SERIAL_RX_BUFFER_MASK] == '\n') {
+      break;
+    }
+    _rx_scanned++;
+  }
+  if (_rx_scanned == count) {
+    if (count == SERIAL_RX_BUFFER_SIZE - 1) {
+      discard(count);
+      return -2;
+    }
+    return -1;
+  }
+
+  if ((unsigned int)tail + _rx_scanned > SERIAL_RX_BUFFER_SIZE) {
+    // The line wraps around the end of the ring; rotate the ring so that
+    // it starts at index 0.  The receive interrupt must not store
+    // characters while the buffer is being rearranged.
+    uint8_t oldSREG = SREG;
+    cli();
+    uint8_t head = _rx_buffer->head;
+    reverse_bytes(_rx_buffer->buffer, 0, tail);
+    reverse_bytes(_rx_buffer->buffer, tail, SERIAL_RX_BUFFER_SIZE);
+    reverse_bytes(_rx_buffer->buffer, 0, SERIAL_RX_BUFFER_SIZE);
+    _rx_buffer->head = (uint8_t)(head - tail) & SERIAL_RX_BUFFER_MASK;
+    _rx_buffer->tail = 0;
+    SREG = oldSREG;
+    tail = 0;
+  }
+  *line = (const char *)&_rx_buffer->buffer[tail];
+  return _rx_scanned;
+}
+
+// Drop the next count characters from the receive buffer.
+void HardwareSerial::discard(size_t count)
+{
+  uint8_t buffered = available();
+  if (count > buffered) {
+    count = buffered;
+  }
+  _rx_buffer->tail = (uint8_t)(_rx_buffer->tail + count) & SERIAL_RX_BUFFER_MASK;
+  _rx_scanned = _rx_scanned > count ? _rx_scanned - count : 0;
+}
+
 void HardwareSerial::flush()
 {
   // UDR is kept full while the buffer is not empty, so TXC triggers when EMPTY && SENT
@@ -461,7 +602,7 @@ void HardwareSerial::flush()
 
 size_t HardwareSerial::write(uint8_t c)
 {
-  int i = (_tx_buffer->head + 1) % SERIAL_BUFFER_SIZE;
+  uint8_t i = (uint8_t)(_tx_buffer->head + 1) & SERIAL_TX_BUFFER_MASK;
 	
   // If the output buffer is full, there's nothing for it other than to 
   // wait for the interrupt handler to empty it a bit
@@ -480,6 +621,70 @@ size_t HardwareSerial::write(uint8_t c)
   return 1;
 }
 
+// Copy the data into the transmit buffer in contiguous chunks, touching the
+// control registers once per chunk instead of once per byte.
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (size == 0) {
+    return 0;
+  }
+  // clear the TXC bit before queueing anything so that it can only be set
+  // again once all of this data has been sent.
+  transmitting = true;
+  sbi(*_ucsra, TXC0);
+
+  size_t remaining = size;
+  while (remaining) {
+    uint8_t head = _tx_buffer->head;
+    // one slot is always left empty to tell a full buffer from an empty one
+    uint8_t space = (uint8_t)(_tx_buffer->tail - head - 1) & SERIAL_TX_BUFFER_MASK;
+    if (space == 0) {
+      // If the output buffer is full, there's nothing for it other than to
+      // wait for the interrupt handler to empty it a bit
+      continue;
+    }
+    size_t chunk = SERIAL_TX_BUFFER_SIZE - (unsigned int)head;
+    if (chunk > space) {
+      chunk = space;
+    }
+    if (chunk > remaining) {
+      chunk = remaining;
+    }
+    memcpy(&_tx_buffer->buffer[head], buffer, chunk);
+    buffer += chunk;
+    remaining -= chunk;
+    _tx_buffer->head = (uint8_t)(head + chunk) & SERIAL_TX_BUFFER_MASK;
+    sbi(*_ucsrb, _udrie);
+  }
+  return size;
+}
+
+// Queue a string in program memory for transmission.  The data register
+// empty interrupt reads it straight from flash when its turn comes, so it
+// needs no RAM staging and this returns right away unless the queue of
+// pending strings is full.
+size_t HardwareSerial::write_P(const char *flash, size_t size)
+{
+  if (size == 0) {
+    return 0;
+  }
+  transmitting = true;
+  sbi(*_ucsra, TXC0);
+
+  uint8_t next = (uint8_t)(_tx_buffer->flash_head + 1) & SERIAL_TX_FLASH_QUEUE_MASK;
+  // If the queue is full, wait for the interrupt handler to finish a string.
+  while (next == _tx_buffer->flash_tail)
+    ;
+  tx_flash_segment *segment = &_tx_buffer->flash[_tx_buffer->flash_head];
+  segment->data = flash;
+  segment->remaining = size;
+  segment->position = _tx_buffer->head;
+  _tx_buffer->flash_head = next;
+
+  sbi(*_ucsrb, _udrie);
+  return size;
+}
+
 HardwareSerial::operator bool() {
 	return true;
 }
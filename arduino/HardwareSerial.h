@@ -27,13 +27,14 @@
 
 #include "Stream.h"
 
-struct ring_buffer;
+struct rx_ring_buffer;
+struct tx_ring_buffer;
 
 class HardwareSerial : public Stream
 {
   private:
-    ring_buffer *_rx_buffer;
-    ring_buffer *_tx_buffer;
+    rx_ring_buffer *_rx_buffer;
+    tx_ring_buffer *_tx_buffer;
     volatile uint8_t *_ubrrh;
     volatile uint8_t *_ubrrl;
     volatile uint8_t *_ucsra;
@@ -46,8 +47,9 @@ class HardwareSerial : public Stream
     uint8_t _udrie;
     uint8_t _u2x;
     bool transmitting;
+    uint8_t _rx_scanned;
   public:
-    HardwareSerial(ring_buffer *rx_buffer, ring_buffer *tx_buffer,
+    HardwareSerial(rx_ring_buffer *rx_buffer, tx_ring_buffer *tx_buffer,
       volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
       volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
       volatile uint8_t *ucsrc, volatile uint8_t *udr,
@@ -60,11 +62,15 @@ class HardwareSerial : public Stream
     virtual int read(void);
     virtual void flush(void);
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual size_t write_P(const char *flash, size_t size);
     inline size_t write(unsigned long n) { return write((uint8_t)n); }
     inline size_t write(long n) { return write((uint8_t)n); }
     inline size_t write(unsigned int n) { return write((uint8_t)n); }
     inline size_t write(int n) { return write((uint8_t)n); }
     using Print::write; // pull in write(str) and write(buf, size) from Print
+    int peekLine(const char **line);
+    void discard(size_t count);
     operator bool();
 };
 
@@ -39,18 +39,27 @@ size_t Print::write(const uint8_t *buffer, size_t size)
   return n;
 }
 
-size_t Print::print(const __FlashStringHelper *ifsh)
+/* default implementation: may be overridden */
+size_t Print::write_P(const char *flash, size_t size)
 {
-  const char * __attribute__((progmem)) p = (const char * ) ifsh;
+  uint8_t buffer[16];
   size_t n = 0;
-  while (1) {
-    unsigned char c = pgm_read_byte(p++);
-    if (c == 0) break;
-    n += write(c);
+  while (size) {
+    size_t chunk = size < sizeof(buffer) ? size : sizeof(buffer);
+    memcpy_P(buffer, flash, chunk);
+    n += write(buffer, chunk);
+    flash += chunk;
+    size -= chunk;
   }
   return n;
 }
 
+size_t Print::print(const __FlashStringHelper *ifsh)
+{
+  const char * __attribute__((progmem)) p = (const char * ) ifsh;
+  return write_P(p, strlen_P(p));
+}
+
 size_t Print::print(const String &s)
 {
   size_t n = 0;
@@ -0,0 +1,451 @@
+#include "Adc.h"
+#include "AnalogFilter.h"
+#include "IsrRing.h"
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+namespace ino {
+
+enum class AdcMode: uint8_t {
+	Idle,
+	Scan,
+	Stream
+};
+
+static volatile AdcMode mode = AdcMode::Idle;
+// Whether scanning should resume when a stream stops.
+static bool scan_enabled = false;
+// Switched off, with the multiplexer lent to the analog comparator.
+static bool released = false;
+
+// Latest result of each scanned channel, written by the ADC interrupt.
+static volatile uint16_t scan_cache[adc_scan_channels];
+static volatile uint8_t scan_valid = 0u;
+static uint8_t scan_channel = 0u;
+
+// Samples written by the ADC interrupt and read by adc_take_samples().
+static IsrRing<uint16_t, adc_stream_capacity, uint16_t> stream_ring;
+static volatile uint16_t stream_latest = 0u;
+static uint8_t stream_channel = 0u;
+static uint8_t stream_divider = 1u;
+static uint8_t stream_skip = 0u;
+
+// Filter chain of each scanned channel, fed by the scan and by streams of the channel.
+static AnalogFilter filters[adc_scan_channels];
+
+static AdcConfig config = adc_default_config;
+// Set when the reference changed and no conversion has been thrown away since.
+static bool reference_unsettled = false;
+static volatile bool eight_bit = false;
+
+static uint8_t mux_bits(uint8_t channel) {
+	uint8_t bits = static_cast<uint8_t>(static_cast<uint8_t>(config.reference) << REFS0);
+	if(eight_bit) {
+		bits |= _BV(ADLAR);
+	}
+	return bits | (channel & 0x07u);
+}
+
+/** The result of the last conversion, in the configured resolution. */
+static uint16_t result() {
+	if(eight_bit) {
+		return ADCH;
+	}
+	return ADC;
+}
+
+static void scan_complete(uint16_t sample) {
+	scan_cache[scan_channel] = sample;
+	scan_valid |= _BV(scan_channel);
+	filters[scan_channel].feed(sample);
+	if(++scan_channel == adc_scan_channels) {
+		scan_channel = 0u;
+	}
+	ADMUX = mux_bits(scan_channel);
+	ADCSRA |= _BV(ADSC);
+}
+
+static void stream_complete(uint16_t sample) {
+	stream_latest = sample;
+	if(stream_channel < adc_scan_channels) {
+		AnalogFilter& filter = filters[stream_channel];
+		bool filtered = filter.feed(sample);
+		if(filter.active()) {
+			// The ring gets the filter's outputs instead of the raw samples.
+			if(not filtered) {
+				return;
+			}
+			sample = filter.output();
+		}
+	}
+	if(++stream_skip < stream_divider) {
+		return;
+	}
+	stream_skip = 0u;
+	stream_ring.push(sample);
+}
+
+ISR(ADC_vect) {
+	uint16_t sample = result();
+	switch(mode) {
+	case AdcMode::Scan:
+		scan_complete(sample);
+		break;
+	case AdcMode::Stream:
+		stream_complete(sample);
+		break;
+	case AdcMode::Idle:
+		break;
+	}
+}
+
+/** Stop interrupt-driven conversions and wait for the one in flight. */
+static void halt() {
+	ADCSRA &= ~(_BV(ADATE) | _BV(ADIE));
+	while(ADCSRA & _BV(ADSC)) {
+		// Let the last conversion finish.
+	}
+	ADCSRA |= _BV(ADIF);
+	mode = AdcMode::Idle;
+}
+
+static void start_scan() {
+	scan_channel = 0u;
+	ADMUX = mux_bits(scan_channel);
+	ADCSRA |= _BV(ADIF);
+	mode = AdcMode::Scan;
+	ADCSRA |= _BV(ADIE) | _BV(ADSC);
+}
+
+/** Restart the scan after a pause, which leaves the cache and the filters stale. */
+static void resume_scan() {
+	scan_valid = 0u;
+	for(AnalogFilter& filter: filters) {
+		filter.reset();
+	}
+	start_scan();
+}
+
+static uint16_t convert(uint8_t channel) {
+	ADMUX = mux_bits(channel);
+	ADCSRA |= _BV(ADSC);
+	while(ADCSRA & _BV(ADSC)) {
+		// Wait for the conversion (13 ADC clocks).
+	}
+	return result();
+}
+
+/** convert(), with the CPU in the ADC Noise Reduction sleep mode meanwhile.  Interrupts must be enabled. */
+static uint16_t convert_asleep(uint8_t channel) {
+	ADMUX = mux_bits(channel);
+	// ADC_vect wakes the CPU; in the idle mode it only clears ADIF.
+	ADCSRA |= _BV(ADIE);
+	set_sleep_mode(SLEEP_MODE_ADC);
+	sleep_enable();
+	// Going to sleep starts the conversion.  Another interrupt may wake the CPU first;
+	// going back to sleep then leaves the conversion in flight alone.
+	do {
+		sleep_cpu();
+	} while(ADCSRA & _BV(ADSC));
+	sleep_disable();
+	ADCSRA &= ~_BV(ADIE);
+	return result();
+}
+
+int adc_read(uint8_t channel) {
+	if(released) {
+		return adc_busy;
+	}
+	switch(mode) {
+	case AdcMode::Stream:
+		if(channel == stream_channel) {
+			uint8_t oldSREG = SREG;
+			cli();
+			uint16_t sample = stream_latest;
+			SREG = oldSREG;
+			return sample;
+		}
+		return adc_busy;
+	case AdcMode::Scan:
+		if(channel < adc_scan_channels) {
+			while(not (scan_valid & _BV(channel))) {
+				// Only until the first round of the scan gets to this channel.
+			}
+			uint8_t oldSREG = SREG;
+			cli();
+			uint16_t sample = scan_cache[channel];
+			SREG = oldSREG;
+			return sample;
+		} else {
+			halt();
+			uint16_t sample = convert(channel);
+			start_scan();
+			return sample;
+		}
+	case AdcMode::Idle:
+		if(scan_enabled) {
+			// Paused by adc_convert().
+			resume_scan();
+			return adc_read(channel);
+		}
+		break;
+	}
+	return convert(channel);
+}
+
+int adc_convert(uint8_t channel) {
+	if(released) {
+		return adc_busy;
+	}
+	switch(mode) {
+	case AdcMode::Stream:
+		return adc_busy;
+	case AdcMode::Scan:
+		halt();
+		break;
+	case AdcMode::Idle:
+		break;
+	}
+	return convert(channel);
+}
+
+int adc_oversample(uint8_t channel, uint8_t extra_bits, bool asleep) {
+	if(released) {
+		return adc_busy;
+	}
+	switch(mode) {
+	case AdcMode::Stream:
+		return adc_busy;
+	case AdcMode::Scan:
+		halt();
+		break;
+	case AdcMode::Idle:
+		break;
+	}
+	if(extra_bits > adc_max_extra_bits) {
+		extra_bits = adc_max_extra_bits;
+	}
+	// At most 16 ten-bit results, so the sum fits in 16 bits.
+	uint8_t count = static_cast<uint8_t>(1u << (2u * extra_bits));
+	uint16_t sum = 0u;
+	for(uint8_t i = 0u; i < count; ++i) {
+		sum += asleep ? convert_asleep(channel) : convert(channel);
+	}
+	return sum >> extra_bits;
+}
+
+int adc_read_filtered(uint8_t channel) {
+	if(released or channel >= adc_scan_channels) {
+		return adc_busy;
+	}
+	switch(mode) {
+	case AdcMode::Stream:
+		if(channel != stream_channel) {
+			return adc_busy;
+		}
+		break;
+	case AdcMode::Scan:
+		break;
+	case AdcMode::Idle:
+		if(not scan_enabled) {
+			return adc_busy;
+		}
+		// Paused by adc_convert().
+		resume_scan();
+		break;
+	}
+	for(;;) {
+		uint8_t oldSREG = SREG;
+		cli();
+		bool valid = filters[channel].valid();
+		uint16_t value = filters[channel].output();
+		SREG = oldSREG;
+		if(valid) {
+			return value;
+		}
+		// Until the first output after the filter (re)started.
+	}
+}
+
+bool adc_set_filter(uint8_t channel, const AnalogFilterConfig& filter) {
+	if(channel >= adc_scan_channels) {
+		return false;
+	}
+	uint8_t oldSREG = SREG;
+	cli();
+	bool good = filters[channel].configure(filter);
+	SREG = oldSREG;
+	return good;
+}
+
+AnalogFilterConfig adc_filter(uint8_t channel) {
+	if(channel >= adc_scan_channels) {
+		return analog_filter_off;
+	}
+	uint8_t oldSREG = SREG;
+	cli();
+	AnalogFilterConfig filter = filters[channel].config();
+	SREG = oldSREG;
+	return filter;
+}
+
+/**
+ * After a change of reference the first conversion may be wrong, and the bandgap takes
+ * up to 70us to start, so wait and throw one conversion away.  The ADC must be idle.
+ */
+static void settle_reference() {
+	if(not reference_unsettled) {
+		return;
+	}
+	reference_unsettled = false;
+	if(config.reference == AdcReference::Internal1V1) {
+		delayMicroseconds(70);
+	}
+	(void)convert(0u);
+}
+
+bool adc_configure(const AdcConfig& new_config) {
+	uint8_t prescaler_bits = 0u;
+	while(prescaler_bits < 7u and (2u << prescaler_bits) != new_config.prescaler) {
+		++prescaler_bits;
+	}
+	if((2u << prescaler_bits) != new_config.prescaler or (new_config.bits != 8u and new_config.bits != 10u)) {
+		return false;
+	}
+	AdcMode resume = mode;
+	halt();
+	if(new_config.reference != config.reference) {
+		reference_unsettled = true;
+	}
+	config = new_config;
+	eight_bit = config.bits == 8u;
+	for(AnalogFilter& filter: filters) {
+		filter.reset();
+	}
+	// ADPS2:0 = log2(prescaler); 0 would also mean /2.
+	ADCSRA = (ADCSRA & ~(_BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0))) | (prescaler_bits + 1u);
+	if(released) {
+		// The comparator has the multiplexer; the settings apply from adc_reclaim().
+		return true;
+	}
+	ADMUX = mux_bits(0u);
+	settle_reference();
+	switch(resume) {
+	case AdcMode::Scan:
+		resume_scan();
+		break;
+	case AdcMode::Stream:
+		adc_start_stream(stream_channel, stream_divider);
+		break;
+	case AdcMode::Idle:
+		break;
+	}
+	return true;
+}
+
+AdcConfig adc_config() {
+	return config;
+}
+
+void adc_start_scan() {
+	scan_enabled = true;
+	if(mode == AdcMode::Idle and not released) {
+		resume_scan();
+	}
+}
+
+void adc_stop_scan() {
+	scan_enabled = false;
+	if(mode == AdcMode::Scan) {
+		halt();
+	}
+}
+
+bool adc_scanning() {
+	return mode == AdcMode::Scan;
+}
+
+bool adc_start_stream(uint8_t channel, uint8_t divider) {
+	if(released) {
+		return false;
+	}
+	halt();
+	stream_channel = channel;
+	stream_divider = divider == 0u ? 1u : divider;
+	stream_skip = 0u;
+	if(channel < adc_scan_channels) {
+		filters[channel].reset();
+	}
+	stream_ring.clear();
+	(void)stream_ring.take_dropped();
+	ADMUX = mux_bits(channel);
+	// Free-running auto trigger.
+	ADCSRB &= ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0));
+	mode = AdcMode::Stream;
+	ADCSRA |= _BV(ADATE) | _BV(ADIE) | _BV(ADSC);
+	return true;
+}
+
+void adc_stop_stream() {
+	if(mode != AdcMode::Stream) {
+		return;
+	}
+	halt();
+	if(scan_enabled) {
+		resume_scan();
+	}
+}
+
+bool adc_release(uint8_t channel) {
+	if(mode == AdcMode::Stream) {
+		return false;
+	}
+	halt();
+	released = true;
+	ADCSRA &= ~_BV(ADEN);
+	ADMUX = channel & 0x07u;
+	return true;
+}
+
+void adc_reclaim() {
+	if(not released) {
+		return;
+	}
+	released = false;
+	ADCSRA |= _BV(ADEN);
+	ADMUX = mux_bits(0u);
+	settle_reference();
+	if(scan_enabled) {
+		resume_scan();
+	}
+}
+
+bool adc_released() {
+	return released;
+}
+
+bool adc_streaming() {
+	return mode == AdcMode::Stream;
+}
+
+uint8_t adc_stream_channel() {
+	return stream_channel;
+}
+
+uint8_t adc_stream_available() {
+	return stream_ring.size();
+}
+
+uint8_t adc_take_samples(Span<uint16_t> samples) {
+	uint8_t count = 0u;
+	while(count < samples.size() and stream_ring.pop(samples[count])) {
+		++count;
+	}
+	return count;
+}
+
+uint16_t adc_take_overruns() {
+	return stream_ring.take_dropped();
+}
+
+} /* namespace ino */
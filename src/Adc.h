@@ -0,0 +1,170 @@
+#ifndef INO_ADC_H
+#define INO_ADC_H
+
+#include <Arduino.h>
+#include "Span.h"
+#include "AnalogFilter.h"
+
+namespace ino {
+
+/**
+ * The analog-to-digital converter.  This module owns the ADC registers and ADC_vect;
+ * nothing else should call analogRead().
+ *
+ * The ADC is in one of three modes:
+ *   - idle: adc_read() starts a conversion and waits for it;
+ *   - scanning: the ADC-complete interrupt cycles the multiplexer through A0-A5 and
+ *     keeps the latest result of each, so adc_read() is a table lookup;
+ *   - streaming: one channel is converted back to back in free-running mode and the
+ *     interrupt stores every 'divider'th result in a RAM ring, which
+ *     adc_take_samples() drains.  Scanning resumes when the stream stops.
+ *
+ * adc_oversample() goes the other way: it sums 4^n conversions and keeps n more bits
+ * than the configured resolution, which works when there is at least an LSB of noise on
+ * the input.  It can convert in the ADC Noise Reduction sleep mode, which stops the CPU
+ * and I/O clocks for the length of each conversion.
+ *
+ * Each of A0-A5 has an AnalogFilter, set by adc_set_filter(), that the interrupt feeds
+ * every conversion of the channel, scanned or streamed.  A stream of a filtered channel
+ * carries the filter's outputs instead of the raw samples.
+ *
+ * adc_release() switches the ADC off altogether so that the analog comparator can use
+ * its multiplexer; reads fail until adc_reclaim().
+ *
+ * adc_configure() trades resolution for speed: with 8-bit results the ADC left-adjusts
+ * (ADLAR) and only ADCH is read, and a faster prescaler is usable.  Every result, from
+ * adc_read() or from a stream, is in the configured resolution.
+ */
+
+/** Voltage reference, as the REFS1:0 bits of ADMUX. */
+enum class AdcReference: uint8_t {
+	External    = 0u,
+	AVcc        = 1u,
+	Internal1V1 = 3u
+};
+
+struct AdcConfig {
+	/** ADC clock divider: 2, 4, 8, 16, 32, 64 or 128. */
+	uint8_t prescaler;
+	/** 8 (left-adjusted, ADCH only) or 10. */
+	uint8_t bits;
+	AdcReference reference;
+};
+
+/** /128 (125kHz ADC clock), 10 bits, AVcc: the settings analogRead() uses. */
+inline constexpr AdcConfig adc_default_config = AdcConfig{128u, 10u, AdcReference::AVcc};
+
+/** Number of channels scanned in the background (A0-A5). */
+inline constexpr uint8_t adc_scan_channels = 6u;
+
+/**
+ * Change the ADC settings.  Returns false, changing nothing, if the prescaler or the
+ * resolution is not one of the values above.  A running scan or stream restarts with
+ * the new settings.
+ */
+bool adc_configure(const AdcConfig& config);
+
+[[nodiscard]]
+AdcConfig adc_config();
+
+/** Number of samples the stream ring holds. */
+inline constexpr uint8_t adc_stream_capacity = 128u;
+
+/** Value returned by adc_read() when the ADC is busy streaming another channel. */
+inline constexpr int adc_busy = -1;
+
+/**
+ * Read 'channel' (0 for A0, ... 7 for A7).  While scanning, returns the cached result;
+ * otherwise converts the channel and waits for the result.  While streaming, returns
+ * the newest sample of the streamed channel, or 'adc_busy' for any other channel.
+ * A scan paused by adc_convert() resumes here.
+ */
+int adc_read(uint8_t channel);
+
+/**
+ * Convert 'channel' now and wait for the result, rather than returning a cached one.
+ * A running scan is paused, so back-to-back calls are not slowed down by it; the next
+ * adc_read() or adc_start_scan() resumes it.  Returns 'adc_busy' while streaming.
+ */
+int adc_convert(uint8_t channel);
+
+/** The most bits adc_oversample() adds to the configured resolution. */
+inline constexpr uint8_t adc_max_extra_bits = 2u;
+
+/**
+ * Like adc_convert(), but sums 4^'extra_bits' conversions and decimates the sum to
+ * 'extra_bits' (at most adc_max_extra_bits) bits more than the configured resolution.
+ *
+ * With 'asleep', each conversion runs in the ADC Noise Reduction sleep mode.  Timer0
+ * (millis()), Timer1 (the stepper) and the UART stop while the CPU sleeps: millis()
+ * falls behind, the stepper stalls, and bytes sent or received in the meantime are
+ * garbled, so the caller should flush its output first.
+ */
+int adc_oversample(uint8_t channel, uint8_t extra_bits, bool asleep);
+
+/**
+ * The latest output of the filter of 'channel' (0 for A0, ... 5 for A5), waiting for
+ * the first one if need be.  Returns 'adc_busy' unless the channel is being scanned or
+ * streamed, since nothing feeds the filter otherwise.
+ */
+int adc_read_filtered(uint8_t channel);
+
+/**
+ * Set the filter of 'channel' and restart it.  Returns false, changing nothing, for
+ * channels that are not scanned or settings out of range.
+ */
+bool adc_set_filter(uint8_t channel, const AnalogFilterConfig& filter);
+
+/** The filter settings of 'channel'; analog_filter_off for channels that have none. */
+[[nodiscard]]
+AnalogFilterConfig adc_filter(uint8_t channel);
+
+/** Start scanning A0-A5 in the background (after the stream, if one is running). */
+void adc_start_scan();
+
+void adc_stop_scan();
+
+[[nodiscard]]
+bool adc_scanning();
+
+/**
+ * Start streaming 'channel', keeping one conversion in 'divider' (at least 1).
+ * Returns false while the ADC is released to the comparator.
+ */
+bool adc_start_stream(uint8_t channel, uint8_t divider = 1u);
+
+void adc_stop_stream();
+
+/**
+ * Stop converting, switch the ADC off and select 'channel' on the multiplexer, for the
+ * analog comparator to use (its multiplexed input needs the ADC off).  Until
+ * adc_reclaim(), every read returns 'adc_busy'.  Returns false, changing nothing, while
+ * streaming.
+ */
+bool adc_release(uint8_t channel);
+
+/** Switch the ADC back on after adc_release(), resuming the scan if it was enabled. */
+void adc_reclaim();
+
+[[nodiscard]]
+bool adc_released();
+
+[[nodiscard]]
+bool adc_streaming();
+
+[[nodiscard]]
+uint8_t adc_stream_channel();
+
+/** Number of streamed samples waiting in the ring. */
+[[nodiscard]]
+uint8_t adc_stream_available();
+
+/** Move up to 'samples.size()' of the oldest streamed samples into 'samples'; returns how many. */
+uint8_t adc_take_samples(Span<uint16_t> samples);
+
+/** Number of samples dropped because the ring was full since the last call; resets the count. */
+uint16_t adc_take_overruns();
+
+} /* namespace ino */
+
+#endif /* INO_ADC_H */
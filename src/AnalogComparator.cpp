@@ -0,0 +1,82 @@
+#include "AnalogComparator.h"
+#include "Adc.h"
+#include "IsrRing.h"
+#include <avr/interrupt.h>
+
+namespace ino {
+
+// Crossings, written by ANALOG_COMP_vect and read by poll_comparator_event().
+static IsrRing<ComparatorEvent, 8u> events;
+
+static bool running = false;
+static uint8_t pin_index = 0u;
+static ComparatorEdge edge = ComparatorEdge::Both;
+
+ISR(ANALOG_COMP_vect) {
+	// ACO is set while the bandgap (+) is above the input (-).
+	LogicLevel level = (ACSR & _BV(ACO)) ? LogicLevel::Low : LogicLevel::High;
+	events.push(ComparatorEvent{micros(), level});
+}
+
+PinStatus comparator_start(const CheckedPin& pin, ComparatorEdge new_edge) {
+	if(pin.kind() != PinKind::Analog) {
+		return PinStatus::BadPinKind;
+	}
+	// Changing ACIS1:0 may raise a spurious interrupt.
+	ACSR &= ~_BV(ACIE);
+	if(not adc_release(static_cast<uint8_t>(pin.number() - A0))) {
+		if(running) {
+			ACSR |= _BV(ACIE);
+		}
+		return PinStatus::AdcBusy;
+	}
+	ADCSRB |= _BV(ACME);
+	ACSR = _BV(ACBG) | static_cast<uint8_t>(new_edge);
+	// The bandgap takes up to 70us to settle.
+	delayMicroseconds(70);
+	events.clear();
+	ACSR |= _BV(ACI);
+	ACSR |= _BV(ACIE);
+	running = true;
+	pin_index = static_cast<uint8_t>(pin.index());
+	edge = new_edge;
+	return PinStatus::Good;
+}
+
+void comparator_stop() {
+	if(not running) {
+		return;
+	}
+	// The interrupt must be off when ACD changes.
+	ACSR &= ~_BV(ACIE);
+	ACSR = _BV(ACD) | _BV(ACI);
+	ADCSRB &= ~_BV(ACME);
+	running = false;
+	adc_reclaim();
+}
+
+bool comparator_running() {
+	return running;
+}
+
+const CheckedPin& comparator_pin() {
+	return all_pins[pin_index];
+}
+
+ComparatorEdge comparator_edge() {
+	return edge;
+}
+
+LogicLevel comparator_level() {
+	return (ACSR & _BV(ACO)) ? LogicLevel::Low : LogicLevel::High;
+}
+
+bool poll_comparator_event(ComparatorEvent& event) {
+	return events.pop(event);
+}
+
+uint8_t take_dropped_comparator_events() {
+	return events.take_dropped();
+}
+
+} /* namespace ino */
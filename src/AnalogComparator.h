@@ -0,0 +1,69 @@
+#ifndef INO_ANALOG_COMPARATOR_H
+#define INO_ANALOG_COMPARATOR_H
+
+#include <Arduino.h>
+#include "Pins.h"
+
+namespace ino {
+
+/**
+ * The analog comparator, watching one analog pin against the 1.1V bandgap.
+ *
+ * AIN0 and AIN1 (pins 6 and 7) drive the stepper, so the bandgap is the positive input
+ * and the negative input comes through the ADC multiplexer.  That needs the ADC switched
+ * off, so analog reads fail while the comparator runs (see adc_release()).
+ *
+ * The comparator switches in well under a microsecond; ANALOG_COMP_vect timestamps each
+ * crossing with micros() and queues it for poll_comparator_event().  The comparator has
+ * no hysteresis, so a slow or noisy input can cross several times in a row.
+ */
+
+/** Which crossings of the threshold interrupt, as the ACIS1:0 bits of ACSR. */
+enum class ComparatorEdge: uint8_t {
+	Both    = 0u,
+	// The input rising above the threshold: ACO falls.
+	Rising  = _BV(ACIS1),
+	// The input falling below the threshold: ACO rises.
+	Falling = _BV(ACIS1) | _BV(ACIS0)
+};
+
+struct ComparatorEvent {
+	/** micros() in the interrupt handler. */
+	uint32_t time;
+	/** High if the input went above the threshold, Low if it went below. */
+	LogicLevel level;
+};
+
+/**
+ * Watch 'pin' (one of A0-A7) for 'edge' crossings of the bandgap.  Returns
+ * PinStatus::BadPinKind for pins that are not analog, and PinStatus::AdcBusy, changing
+ * nothing, while the ADC is streaming.
+ */
+PinStatus comparator_start(const CheckedPin& pin, ComparatorEdge edge);
+
+/** Switch the comparator off and give the ADC back. */
+void comparator_stop();
+
+[[nodiscard]]
+bool comparator_running();
+
+/** The pin being watched; only meaningful while the comparator runs. */
+[[nodiscard]]
+const CheckedPin& comparator_pin();
+
+[[nodiscard]]
+ComparatorEdge comparator_edge();
+
+/** Whether the input is above the threshold right now. */
+[[nodiscard]]
+LogicLevel comparator_level();
+
+/** Take the oldest queued crossing.  Returns false if there is none. */
+bool poll_comparator_event(ComparatorEvent& event);
+
+/** Number of crossings lost to a full queue since the last call; resets the count. */
+uint8_t take_dropped_comparator_events();
+
+} /* namespace ino */
+
+#endif /* INO_ANALOG_COMPARATOR_H */
@@ -0,0 +1,128 @@
+#ifndef INO_ANALOG_FILTER_H
+#define INO_ANALOG_FILTER_H
+
+#include <Arduino.h>
+
+namespace ino {
+
+struct AnalogFilterConfig {
+	/** Median of the last 1 (off), 3 or 5 samples. */
+	uint8_t median;
+	/** Exponential moving average with a weight of 1/2^ema_shift for each sample; 0 is off. */
+	uint8_t ema_shift;
+	/** Keep one output in 'decimation' (at least 1). */
+	uint8_t decimation;
+};
+
+/** Every stage off: the output is the input. */
+inline constexpr AnalogFilterConfig analog_filter_off = AnalogFilterConfig{1u, 0u, 1u};
+
+/** Largest 'ema_shift'; 1023 << 6 still fits the 16-bit accumulator. */
+inline constexpr uint8_t analog_filter_max_ema_shift = 6u;
+
+/**
+ * Integer filter chain for the samples of one ADC channel: median, then exponential
+ * moving average, then decimation.  Small enough to run in the ADC interrupt.
+ */
+struct AnalogFilter {
+
+	/** Returns false, changing nothing, if 'config' is out of range.  Restarts the filter. */
+	bool configure(const AnalogFilterConfig& config) {
+		if((config.median != 1u and config.median != 3u and config.median != 5u)
+			or config.ema_shift > analog_filter_max_ema_shift
+			or config.decimation == 0u)
+		{
+			return false;
+		}
+		config_ = config;
+		reset();
+		return true;
+	}
+
+	const AnalogFilterConfig& config() const {
+		return config_;
+	}
+
+	bool active() const {
+		return config_.median != 1u or config_.ema_shift != 0u or config_.decimation != 1u;
+	}
+
+	/** Forget the samples seen so far. */
+	void reset() {
+		head_ = 0u;
+		count_ = 0u;
+		skip_ = 0u;
+		valid_ = false;
+	}
+
+	/** Feed one sample; returns true if it produced a new output(). */
+	bool feed(uint16_t sample) {
+		uint16_t value = median(sample);
+		if(config_.ema_shift != 0u) {
+			if(count_ == 1u) {
+				// Start the average at the first sample rather than ramping up from zero.
+				accumulator_ = value << config_.ema_shift;
+			} else {
+				accumulator_ = accumulator_ - (accumulator_ >> config_.ema_shift) + value;
+			}
+			value = accumulator_ >> config_.ema_shift;
+		}
+		if(++skip_ < config_.decimation) {
+			return false;
+		}
+		skip_ = 0u;
+		output_ = value;
+		valid_ = true;
+		return true;
+	}
+
+	uint16_t output() const {
+		return output_;
+	}
+
+	/** Whether there has been an output since the last reset. */
+	bool valid() const {
+		return valid_;
+	}
+
+private:
+
+	uint16_t median(uint16_t sample) {
+		window_[head_] = sample;
+		if(++head_ == 5u) {
+			head_ = 0u;
+		}
+		if(count_ < 5u) {
+			++count_;
+		}
+		uint8_t n = config_.median < count_ ? config_.median : count_;
+		if(n < 3u) {
+			return sample;
+		}
+		uint16_t sorted[5];
+		for(uint8_t i = 0u; i < n; ++i) {
+			uint16_t value = window_[(head_ + 4u - i) % 5u];
+			uint8_t j = i;
+			for(; j > 0u and sorted[j - 1u] > value; --j) {
+				sorted[j] = sorted[j - 1u];
+			}
+			sorted[j] = value;
+		}
+		return sorted[n / 2u];
+	}
+
+	AnalogFilterConfig config_ = analog_filter_off;
+	uint16_t window_[5] = {};
+	uint16_t accumulator_ = 0u;
+	uint16_t output_ = 0u;
+	// Next slot of 'window_'.
+	uint8_t head_ = 0u;
+	// Samples seen, up to 5.
+	uint8_t count_ = 0u;
+	uint8_t skip_ = 0u;
+	bool valid_ = false;
+};
+
+} /* namespace ino */
+
+#endif /* INO_ANALOG_FILTER_H */
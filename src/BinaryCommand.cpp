@@ -0,0 +1,261 @@
+#include "BinaryCommand.h"
+#include "Command.h"
+#include "Pins.h"
+#include "Array.h"
+#include "FlashString.h"
+#include "PinEvents.h"
+#include "ino_assert.h"
+#include <Arduino.h>
+#include <util/crc16.h>
+#include <utility>
+
+// Command headers
+#include "commands/stepper_control.h"
+#include "commands/headlights.h"
+#include "commands/checkengine.h"
+
+namespace ino {
+
+static Protocol protocol = Protocol::Text;
+
+Protocol active_protocol() {
+	return protocol;
+}
+
+void set_active_protocol(Protocol p) {
+	protocol = p;
+}
+
+void write_frame(Print& out, FrameStatus status, Span<const uint8_t> payload) {
+	ASSERT(payload.size() < max_frame_length);
+	const uint8_t header[] = {
+		frame_start,
+		static_cast<uint8_t>(payload.size() + 1u),
+		static_cast<uint8_t>(status)
+	};
+	uint8_t crc = _crc8_ccitt_update(0u, header[1]);
+	crc = _crc8_ccitt_update(crc, header[2]);
+	for(uint8_t byte: payload) {
+		crc = _crc8_ccitt_update(crc, byte);
+	}
+	out.write(header, sizeof(header));
+	out.write(payload.data(), payload.size());
+	out.write(crc);
+}
+
+static const CheckedPin* pin_from_number(uint8_t number) {
+	for(const CheckedPin& pin: ino::all_pins) {
+		if(pin.number() == number) {
+			return &pin;
+		}
+	}
+	return nullptr;
+}
+
+namespace detail {
+
+/**
+ * Describes how a value of type T is packed into a frame.  Each specialization provides
+ * the packed 'size', 'valid()' to check an incoming argument, 'decode()' to unpack it
+ * and, for result types, 'encode()'.
+ */
+template <class T>
+struct FrameCodec;
+
+template <>
+struct FrameCodec<uint8_t> {
+	static constexpr std::size_t size = 1u;
+
+	static bool valid(const uint8_t*) { return true; }
+
+	static uint8_t decode(const uint8_t* p) { return p[0]; }
+
+	static void encode(uint8_t* p, uint8_t value) { p[0] = value; }
+};
+
+template <>
+struct FrameCodec<uint16_t> {
+	static constexpr std::size_t size = 2u;
+
+	static bool valid(const uint8_t*) { return true; }
+
+	static uint16_t decode(const uint8_t* p) {
+		return static_cast<uint16_t>(p[0] | (static_cast<uint16_t>(p[1]) << 8u));
+	}
+
+	static void encode(uint8_t* p, uint16_t value) {
+		p[0] = static_cast<uint8_t>(value);
+		p[1] = static_cast<uint8_t>(value >> 8u);
+	}
+};
+
+/** Enumerations are packed as a single byte that must hold one of 'Values'. */
+template <class Enum, Enum ... Values>
+struct EnumFrameCodec {
+	static constexpr std::size_t size = 1u;
+
+	static bool valid(const uint8_t* p) {
+		return ((p[0] == static_cast<uint8_t>(Values)) or ...);
+	}
+
+	static Enum decode(const uint8_t* p) { return static_cast<Enum>(p[0]); }
+
+	static void encode(uint8_t* p, Enum value) { p[0] = static_cast<uint8_t>(value); }
+};
+
+template <>
+struct FrameCodec<LogicLevel>: EnumFrameCodec<LogicLevel, LogicLevel::Low, LogicLevel::High> {};
+
+template <>
+struct FrameCodec<PinMode>: EnumFrameCodec<PinMode, PinMode::Input, PinMode::Output, PinMode::InputPullup> {};
+
+template <>
+struct FrameCodec<Switch>: EnumFrameCodec<Switch, Switch::Off, Switch::On, Switch::Query> {};
+
+/** Pins are packed as their Arduino pin number. */
+template <>
+struct FrameCodec<const CheckedPin*> {
+	static constexpr std::size_t size = 1u;
+
+	static bool valid(const uint8_t* p) { return pin_from_number(p[0]) != nullptr; }
+
+	static const CheckedPin* decode(const uint8_t* p) { return pin_from_number(p[0]); }
+};
+
+template <class ... Args>
+constexpr std::size_t packed_size() {
+	return (std::size_t(0u) + ... + FrameCodec<Args>::size);
+}
+
+template <std::size_t I, class ... Args>
+constexpr std::size_t packed_offset() {
+	constexpr std::size_t sizes[] = {FrameCodec<Args>::size ..., 0u};
+	std::size_t offset = 0u;
+	for(std::size_t i = 0u; i < I; ++i) {
+		offset += sizes[i];
+	}
+	return offset;
+}
+
+inline void reply(PinStatus status) {
+	write_frame(Serial, static_cast<FrameStatus>(status));
+}
+
+template <class T>
+void reply(const std::pair<T, PinStatus>& result) {
+	if(result.second != PinStatus::Good) {
+		reply(result.second);
+		return;
+	}
+	uint8_t payload[FrameCodec<T>::size];
+	FrameCodec<T>::encode(payload, result.first);
+	write_frame(Serial, FrameStatus::Good, Span<const uint8_t>(payload, sizeof(payload)));
+}
+
+template <class T>
+void reply(const T& value) {
+	reply(std::pair<T, PinStatus>(value, PinStatus::Good));
+}
+
+template <auto Fn, class R, class ... Args, std::size_t ... I>
+void invoke_typed(R (*)(Args ...), Span<const uint8_t> args, ino::detail::index_sequence<I ...>) {
+	if(args.size() != packed_size<Args ...>()) {
+		write_frame(Serial, FrameStatus::BadArguments);
+		return;
+	}
+	if(not (true and ... and FrameCodec<Args>::valid(args.data() + packed_offset<I, Args ...>()))) {
+		write_frame(Serial, FrameStatus::BadArguments);
+		return;
+	}
+	reply(Fn(FrameCodec<Args>::decode(args.data() + packed_offset<I, Args ...>()) ...));
+}
+
+template <class R, class ... Args>
+constexpr std::size_t arity(R (*)(Args ...)) {
+	return sizeof...(Args);
+}
+
+/**
+ * Adapts a typed function such as 'LogicLevel headlights(Switch)' to the binary protocol:
+ * unpacks and validates the arguments from the frame, calls the function and packs the
+ * result into the reply.  Functions may return 'PinStatus', 'std::pair<T, PinStatus>'
+ * or a plain value.
+ */
+template <auto Fn>
+void binary_adapter(Span<const uint8_t> args) {
+	invoke_typed<Fn>(Fn, args, ino::detail::make_index_sequence<arity(Fn)>{});
+}
+
+} /* namespace detail */
+
+struct BinaryCommand {
+	void (*invoke)(Span<const uint8_t>);
+};
+
+template <auto Fn>
+inline constexpr BinaryCommand binary_command = BinaryCommand{&ino::detail::binary_adapter<Fn>};
+
+static PinStatus bin_text() {
+	set_active_protocol(Protocol::Text);
+	return PinStatus::Good;
+}
+
+static PinStatus bin_pinmode(const CheckedPin* pin, PinMode mode) {
+	pin->set_mode(mode);
+	return PinStatus::Good;
+}
+
+static LogicLevel bin_digitalread(const CheckedPin* pin) {
+	return pin->digital_read();
+}
+
+static PinStatus bin_digitalwrite(const CheckedPin* pin, LogicLevel level) {
+	return pin->digital_write(level);
+}
+
+static std::pair<uint16_t, PinStatus> bin_analogread(const CheckedPin* pin) {
+	auto [value, status] = pin->analog_read();
+	return {static_cast<uint16_t>(value), status};
+}
+
+static PinStatus bin_analogwrite(const CheckedPin* pin, uint8_t value) {
+	return pin->analog_write(value);
+}
+
+static PinStatus bin_watch(const CheckedPin* pin) {
+	return watch_pin(*pin);
+}
+
+static PinStatus bin_unwatch(const CheckedPin* pin) {
+	unwatch_pin(*pin);
+	return PinStatus::Good;
+}
+
+// The position of each command in this table is its command ID; only append to it.
+[[gnu::progmem]]
+static constexpr auto binary_command_table = ino::FlashArray{
+	binary_command<bin_text>,
+	binary_command<bin_pinmode>,
+	binary_command<bin_digitalread>,
+	binary_command<bin_digitalwrite>,
+	binary_command<bin_analogread>,
+	binary_command<bin_analogwrite>,
+	binary_command<window>,
+	binary_command<headlights>,
+	binary_command<checkengine_status>,
+	binary_command<checkengine_light>,
+	binary_command<window_stop>,
+	binary_command<bin_watch>,
+	binary_command<bin_unwatch>
+};
+
+void invoke_binary_command(Span<const uint8_t> frame) {
+	if(frame.empty() or frame[0] >= binary_command_table.size()) {
+		write_frame(Serial, FrameStatus::UnknownCommand);
+		return;
+	}
+	BinaryCommand command = *(binary_command_table.begin() + frame[0]);
+	command.invoke(frame.subspan(1u));
+}
+
+} /* namespace ino */
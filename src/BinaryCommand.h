@@ -0,0 +1,80 @@
+#ifndef INO_BINARY_COMMAND_H
+#define INO_BINARY_COMMAND_H
+
+#include <Arduino.h>
+#include <cstddef>
+#include "Span.h"
+#include "Pins.h"
+
+namespace ino {
+
+/**
+ * Framed binary protocol, an alternative to the text REPL for hosts that care about
+ * round-trip time.  Every frame, in either direction, looks like:
+ *
+ *         | 0xA5 | length | id/status | payload ... | crc8 |
+ *
+ * 'length' counts the id/status byte and the payload.  'crc8' is the CRC-8/CCITT
+ * (polynomial 0x07, initial value 0) of the length, id/status and payload bytes.
+ * Requests carry a command ID followed by the packed (little-endian) arguments of
+ * the command.  Replies carry a 'FrameStatus' followed by the packed result.
+ *
+ * Command IDs and their arguments/results (pins are sent as their Arduino pin number):
+ *         0x00 text                                  -> (switches back to the text REPL)
+ *         0x01 pinmode            <pin> <mode>        ->
+ *         0x02 digitalread        <pin>               -> <level>
+ *         0x03 digitalwrite       <pin> <level>       ->
+ *         0x04 analogread         <pin>               -> <uint16>
+ *         0x05 analogwrite        <pin> <uint8>       ->
+ *         0x06 window             <switch>            -> <position>
+ *         0x07 headlights         <switch>            -> <level>
+ *         0x08 checkengine_status                     -> <level>
+ *         0x09 checkengine_light  <switch>            -> <level>
+ *         0x0A window_stop                            -> <position>
+ *         0x0B watch              <pin>               ->
+ *         0x0C unwatch            <pin>               ->
+ *
+ * Notification frames (see Notifications.h) may arrive between replies.
+ */
+inline constexpr uint8_t frame_start = 0xA5u;
+
+/** Maximum number of bytes between the length byte and the CRC of a frame. */
+inline constexpr std::size_t max_frame_length = 32u;
+
+/** Reply status codes.  The low values mirror 'PinStatus'; the rest are protocol errors. */
+enum class FrameStatus: uint8_t {
+	Good                = static_cast<uint8_t>(PinStatus::Good),
+	BadPinMode          = static_cast<uint8_t>(PinStatus::BadPinMode),
+	BadPinKind          = static_cast<uint8_t>(PinStatus::BadPinKind),
+	BadAnalogWriteValue = static_cast<uint8_t>(PinStatus::BadAnalogWriteValue),
+	AdcBusy             = static_cast<uint8_t>(PinStatus::AdcBusy),
+	BadResolution       = static_cast<uint8_t>(PinStatus::BadResolution),
+	BadChecksum         = 0x80u,
+	FrameTooLong        = 0x81u,
+	UnknownCommand      = 0x82u,
+	BadArguments        = 0x83u,
+	Notification        = 0x90u
+};
+
+enum class Protocol {
+	Text,
+	Binary
+};
+
+/** The protocol currently spoken on the serial link. */
+Protocol active_protocol();
+
+void set_active_protocol(Protocol protocol);
+
+/** Write a complete frame (start byte, length, status, payload and CRC) to 'out'. */
+void write_frame(Print& out, FrameStatus status, Span<const uint8_t> payload = {});
+
+/**
+ * Run the binary command encoded in 'frame' (command ID followed by the packed
+ * arguments) and write the reply frame to Serial.
+ */
+void invoke_binary_command(Span<const uint8_t> frame);
+
+} /* namespace ino */
+
+#endif /* INO_BINARY_COMMAND_H */
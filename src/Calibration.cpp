@@ -0,0 +1,58 @@
+#include "Calibration.h"
+
+namespace ino {
+
+/** A voltage on the pin itself: 1023 counts is just under AVcc (5V). */
+static constexpr int16_t pin_millivolts(uint16_t counts) {
+	return static_cast<int16_t>((uint32_t(counts) * 5000u + 512u) / 1024u);
+}
+
+[[gnu::progmem]]
+static constexpr CalibrationTable pin_volts = make_calibration_table(pin_millivolts);
+
+/** The table a channel is converted with, and the unit of its values. */
+struct ChannelCalibration {
+	const CalibrationTable* table;
+	CalibrationUnit unit;
+};
+
+// Channels with a sensor on them get a table for its curve; the rest read in volts.
+[[gnu::progmem]]
+static constexpr FlashArray<ChannelCalibration, calibration_channels> calibrations = {{
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts},
+	{&pin_volts, CalibrationUnit::Volts}
+}};
+
+CalibrationUnit calibration_unit(uint8_t channel) {
+	if(channel >= calibration_channels) {
+		return CalibrationUnit::Volts;
+	}
+	return ChannelCalibration(*(calibrations.begin() + channel)).unit;
+}
+
+int16_t calibrate(uint8_t channel, uint16_t reading, uint8_t bits) {
+	if(channel >= calibration_channels) {
+		channel = calibration_channels - 1u;
+	}
+	const CalibrationTable& table = *ChannelCalibration(*(calibrations.begin() + channel)).table;
+	// Work in 12-bit counts so that oversampled readings keep their extra bits.
+	uint16_t x = bits < 12u ? reading << (12u - bits) : reading >> (bits - 12u);
+	uint8_t i = 0u;
+	while(i + 2u < calibration_points and x >= uint16_t(CalibrationPoint(*(table.begin() + i + 1u)).counts << 2u)) {
+		++i;
+	}
+	// Past the last breakpoint the last segment is extended.
+	CalibrationPoint low = *(table.begin() + i);
+	CalibrationPoint high = *(table.begin() + i + 1u);
+	int32_t x0 = int32_t(low.counts) << 2u;
+	int32_t x1 = int32_t(high.counts) << 2u;
+	return static_cast<int16_t>(low.value + (int32_t(high.value - low.value) * (int32_t(x) - x0)) / (x1 - x0));
+}
+
+} /* namespace ino */
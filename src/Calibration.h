@@ -0,0 +1,67 @@
+#ifndef INO_CALIBRATION_H
+#define INO_CALIBRATION_H
+
+#include <Arduino.h>
+#include "Array.h"
+
+namespace ino {
+
+/**
+ * Conversion of analog readings to engineering units.  Each analog channel maps to a
+ * table of breakpoints in flash, generated at compile time from a curve, and readings
+ * between two breakpoints are interpolated linearly in fixed point.  Channels that read
+ * the same way share one table.
+ *
+ * Breakpoints are in 10-bit counts with the AVcc reference; readings in other
+ * resolutions are scaled to match.
+ */
+
+/**
+ * How calibrated values of a channel read: a fixed-point number and a unit.  A sensor
+ * curve brings its own unit.
+ */
+enum class CalibrationUnit: uint8_t {
+	// Millivolts, shown as volts.
+	Volts
+};
+
+/** A reading of 'counts' stands for 'value', in the channel's CalibrationUnit. */
+struct CalibrationPoint {
+	uint16_t counts;
+	int16_t value;
+};
+
+inline constexpr uint8_t calibration_points = 9u;
+
+/** Number of analog channels (A0-A7) with a calibration. */
+inline constexpr uint8_t calibration_channels = 8u;
+
+using CalibrationTable = FlashArray<CalibrationPoint, calibration_points>;
+
+/**
+ * Sample 'curve', a function from 10-bit counts to a value, at evenly spaced counts
+ * from 0 to 1023.
+ */
+template <class Curve>
+constexpr CalibrationTable make_calibration_table(Curve curve) {
+	CalibrationTable table{};
+	for(uint8_t i = 0u; i < calibration_points; ++i) {
+		uint16_t counts = static_cast<uint16_t>(uint32_t(i) * 1023u / (calibration_points - 1u));
+		table.private_data_[i] = CalibrationPoint{counts, curve(counts)};
+	}
+	return table;
+}
+
+[[nodiscard]]
+CalibrationUnit calibration_unit(uint8_t channel);
+
+/**
+ * Convert 'reading' of 'channel' (0 for A0, ... 7 for A7), taken in 'bits' of
+ * resolution (8 to 12), to the channel's unit.
+ */
+[[nodiscard]]
+int16_t calibrate(uint8_t channel, uint16_t reading, uint8_t bits);
+
+} /* namespace ino */
+
+#endif /* INO_CALIBRATION_H */
@@ -16,6 +16,16 @@
 #include "commands/headlights.h"
 #include "commands/checkengine.h"
 #include "commands/stepper_control.h"
+#include "commands/binary.h"
+#include "commands/portio.h"
+#include "commands/events.h"
+#include "commands/watch.h"
+#include "commands/subscribe.h"
+#include "commands/analogstream.h"
+#include "commands/analogburst.h"
+#include "commands/analogfilter.h"
+#include "commands/comparator.h"
+#include "commands/adcconfig.h"
 
 
 namespace ino {
@@ -150,11 +160,116 @@ static constexpr auto command_table = ino::FlashArray{
 	command<cmd_analogread>,
 	command<cmd_analogwrite>,
 	command<cmd_window>,
+	command<cmd_stepper>,
 	command<cmd_headlights>,
 	command<cmd_checkengine_status>,
-	command<cmd_checkengine_light>
+	command<cmd_checkengine_light>,
+	command<cmd_events>,
+	command<cmd_watch>,
+	command<cmd_unwatch>,
+	command<cmd_subscribe>,
+	command<cmd_unsubscribe>,
+	command<cmd_analogstream>,
+	command<cmd_analogburst>,
+	command<cmd_analogfilter>,
+	command<cmd_comparator>,
+	command<cmd_adcconfig>,
+	command<cmd_portwrite>,
+	command<cmd_portread>,
+	command<cmd_binary>
 };
 
+/**
+ * Hash used to look up commands by name.  The seed is picked at compile time (see
+ * 'command_hash_seed' below) such that every command name lands in its own slot of
+ * 'command_slots', so dispatching a command costs one hash and one name comparison.
+ */
+static constexpr uint16_t command_name_hash(const char* name, std::size_t len, uint16_t seed) {
+	uint16_t h = seed;
+	for(std::size_t i = 0u; i < len; ++i) {
+		h = static_cast<uint16_t>((h << 5u) + h) ^ static_cast<unsigned char>(name[i]);
+	}
+	return h ^ (h >> 8u);
+}
+
+static constexpr std::size_t next_power_of_two(std::size_t n) {
+	std::size_t p = 1u;
+	while(p < n) {
+		p <<= 1u;
+	}
+	return p;
+}
+
+// At least twice as many slots as commands so that a collision-free seed is found quickly.
+static constexpr std::size_t command_slot_count = next_power_of_two(2u * command_table.size());
+static constexpr uint8_t no_command = 0xFFu;
+static_assert(command_table.size() < no_command, "Too many commands for 8-bit command slots.");
+
+static constexpr std::size_t command_slot(ino::FlashStringView<> name, uint16_t seed) {
+	return command_name_hash(name.data().get(), name.size(), seed) & (command_slot_count - 1u);
+}
+
+static constexpr bool command_hash_is_perfect(uint16_t seed) {
+	bool used[command_slot_count] = {};
+	for(std::size_t i = 0u; i < command_table.size(); ++i) {
+		auto slot = command_slot(command_table.data().get()[i].name(), seed);
+		if(used[slot]) {
+			return false;
+		}
+		used[slot] = true;
+	}
+	return true;
+}
+
+static constexpr uint16_t find_command_hash_seed() {
+	for(uint16_t seed = 0u; seed < 0xFFFFu; ++seed) {
+		if(command_hash_is_perfect(seed)) {
+			return seed;
+		}
+	}
+	return 0u;
+}
+
+static constexpr uint16_t command_hash_seed = find_command_hash_seed();
+static_assert(
+	command_hash_is_perfect(command_hash_seed),
+	"No collision-free hash seed exists for the command names; increase 'command_slot_count'."
+);
+
+static constexpr ino::FlashArray<uint8_t, command_slot_count> make_command_slots() {
+	ino::FlashArray<uint8_t, command_slot_count> slots{};
+	for(std::size_t i = 0u; i < command_slot_count; ++i) {
+		slots.private_data_[i] = no_command;
+	}
+	for(std::size_t i = 0u; i < command_table.size(); ++i) {
+		auto slot = command_slot(command_table.data().get()[i].name(), command_hash_seed);
+		slots.private_data_[slot] = static_cast<uint8_t>(i);
+	}
+	return slots;
+}
+
+// Maps 'command_name_hash()' slots to indices into 'command_table'.
+[[gnu::progmem]]
+static constexpr auto command_slots = make_command_slots();
+
+/**
+ * Look up the command with the given name.  Returns 'command_table.end()' if no such
+ * command exists.
+ */
+static ino::ProgmemPtr<Command> find_command(StringView<> name) {
+	auto slot = command_name_hash(name.data(), name.size(), command_hash_seed) & (command_slot_count - 1u);
+	uint8_t index = command_slots.data()[slot];
+	if(index == no_command) {
+		return command_table.end();
+	}
+	auto pos = command_table.begin() + index;
+	Command cmd = *pos;
+	if(cmd.name() != name) {
+		return command_table.end();
+	}
+	return pos;
+}
+
 static void print_left_justified(ino::FlashStringView<> s, std::size_t width) {
 	std::size_t i = 0u;
 	Serial.print(s);
@@ -231,11 +346,7 @@ int invoke_command(Span<StringView<>> argv) {
 		// blank line
 		return 0;
 	}
-	auto pos = std::find_if(
-		command_table.begin(),
-		command_table.end(),
-		[argv](Command cmd) { return cmd.name() == argv[0]; }
-	);
+	auto pos = find_command(argv[0]);
 	if(pos == command_table.end()) {
 		return command_error("Unknown command '", argv[0], "'.");
 	} else {
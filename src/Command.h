@@ -30,6 +30,16 @@ enum class CommandTrait {
 
 struct CommandTraitsBase {};
 
+/**
+ * Requested action for commands that switch something on or off.  Shared by the text
+ * commands and their binary protocol counterparts.
+ */
+enum class Switch: uint8_t {
+	Off   = 0u,
+	On    = 1u,
+	Query = 2u
+};
+
 
 /**
  * @tparam NameSz  - Size of the command 'name' string (NOT including null terminator).
@@ -0,0 +1,139 @@
+#ifndef INO_EEPROM_RECORD_H
+#define INO_EEPROM_RECORD_H
+
+#include <Arduino.h>
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#include <string.h>
+
+namespace ino {
+
+/**
+ * Keeps the latest value of a small record in EEPROM, wear-levelled over 'Slots' copies
+ * starting at 'Address'.  Each slot holds a sequence number, the record and a CRC-8 of
+ * both; every save() goes to the slot after the newest one, so each cell sees one write
+ * in 'Slots'.  A slot torn by a reset fails its CRC and the previous one is used.
+ *
+ * Writes run in the background, one byte per EEPROM ready interrupt, so save() returns
+ * immediately and can be called from an interrupt handler.  The owner must forward
+ * EE_READY_vect to ready_interrupt().
+ */
+template <class Record, uint16_t Address, uint8_t Slots>
+struct EepromRecord {
+
+	static constexpr uint8_t slot_size = sizeof(Record) + 2u;
+
+	static_assert(Slots > 1u and Slots < 128u, "EepromRecord needs between 2 and 127 slots.");
+	static_assert(Address + uint32_t(Slots) * slot_size <= E2END + 1ul, "EepromRecord does not fit in the EEPROM.");
+
+	/**
+	 * Read back the newest valid record.  Returns false (and leaves 'record' alone) if
+	 * there is none, as on a blank EEPROM.  Waits for any write in progress.
+	 */
+	bool load(Record& record) {
+		while(EECR & _BV(EERIE)) {
+			// Let the background write finish.
+		}
+		while(EECR & _BV(EEPE)) {
+			// Let the last byte finish.
+		}
+		uint8_t newest = no_slot;
+		uint8_t slot[slot_size];
+		uint8_t next[slot_size];
+		for(uint8_t i = 0u; i < Slots; ++i) {
+			read_slot(i, slot);
+			if(not valid(slot)) {
+				continue;
+			}
+			// The newest slot is the one not followed by its successor in the sequence.
+			read_slot((i + 1u) % Slots, next);
+			if(valid(next) and next[0] == static_cast<uint8_t>(slot[0] + 1u)) {
+				continue;
+			}
+			newest = i;
+			sequence_ = slot[0];
+			memcpy(&record, slot + 1u, sizeof(Record));
+			break;
+		}
+		slot_ = newest == no_slot ? Slots - 1u : newest;
+		return newest != no_slot;
+	}
+
+	/** Queue 'record' to be written.  Only the newest of several pending records is kept. */
+	void save(const Record& record) {
+		uint8_t oldSREG = SREG;
+		cli();
+		pending_ = record;
+		has_pending_ = true;
+		if(not (EECR & _BV(EERIE))) {
+			start_next();
+		}
+		SREG = oldSREG;
+	}
+
+	/** Must be called from EE_READY_vect. */
+	void ready_interrupt() {
+		while(written_ < slot_size) {
+			uint16_t address = Address + uint16_t(slot_) * slot_size + written_;
+			uint8_t byte = buffer_[written_++];
+			EEAR = address;
+			EECR |= _BV(EERE);
+			if(EEDR != byte) {
+				// Erase and write; the next interrupt comes when it is done.
+				EEDR = byte;
+				EECR |= _BV(EEMPE);
+				EECR |= _BV(EEPE);
+				return;
+			}
+		}
+		if(has_pending_) {
+			start_next();
+		} else {
+			EECR &= ~_BV(EERIE);
+		}
+	}
+
+private:
+
+	static constexpr uint8_t no_slot = 0xFFu;
+
+	static void read_slot(uint8_t index, uint8_t* slot) {
+		eeprom_read_block(slot, reinterpret_cast<const void*>(Address + uint16_t(index) * slot_size), slot_size);
+	}
+
+	static uint8_t checksum(const uint8_t* slot) {
+		uint8_t crc = 0u;
+		for(uint8_t i = 0u; i < slot_size - 1u; ++i) {
+			crc = _crc8_ccitt_update(crc, slot[i]);
+		}
+		return crc;
+	}
+
+	static bool valid(const uint8_t* slot) {
+		return checksum(slot) == slot[slot_size - 1u];
+	}
+
+	/** Lay out the pending record in the next slot.  Must be called with interrupts disabled. */
+	void start_next() {
+		slot_ = (slot_ + 1u) % Slots;
+		++sequence_;
+		buffer_[0] = sequence_;
+		memcpy(buffer_ + 1u, &pending_, sizeof(Record));
+		buffer_[slot_size - 1u] = checksum(buffer_);
+		written_ = 0u;
+		has_pending_ = false;
+		EECR |= _BV(EERIE);
+	}
+
+	Record pending_ = {};
+	volatile bool has_pending_ = false;
+	uint8_t buffer_[slot_size] = {};
+	uint8_t written_ = slot_size;
+	uint8_t slot_ = Slots - 1u;
+	uint8_t sequence_ = 0u;
+};
+
+} /* namespace ino */
+
+#endif /* INO_EEPROM_RECORD_H */
@@ -77,17 +77,8 @@ struct FlashStringView {
 	constexpr reverse_iterator   crend() const { return rend(); }
 
 	std::size_t print_to(Print& print) const {
-		std::size_t count = 0u;
-		unsigned char buff[32];
-		auto cpy = *this;
-		while(cpy.size() >= sizeof(buff)) {
-			memcpy_P(buff, cpy.data().flash_address(), sizeof(buff));
-			count += print.write(buff, sizeof(buff));
-			cpy.remove_prefix(sizeof(buff));
-		}
-		memcpy_P(buff, cpy.data().flash_address(), cpy.size());
-		count += print.write(buff, cpy.size());
-		return count;
+		// Serial sends the string straight from flash.
+		return print.write_P(reinterpret_cast<const char*>(data().flash_address()), size() * sizeof(Char));
 	}
 
 	constexpr void remove_suffix(size_type len) {
@@ -0,0 +1,78 @@
+#ifndef INO_ISR_RING_H
+#define INO_ISR_RING_H
+
+#include <Arduino.h>
+#include <avr/interrupt.h>
+
+namespace ino {
+
+/**
+ * A queue from one interrupt handler, which push()es, to the main loop, which pop()s.
+ * The handler only moves the head and the main loop only moves the tail, so neither
+ * side has to disable interrupts.  Pushes into a full ring are dropped and counted, in
+ * a 'Counter' that saturates.
+ */
+template <class T, uint8_t Size, class Counter = uint8_t>
+struct IsrRing {
+
+	static_assert(Size != 0u and Size <= 128u and (Size & (Size - 1u)) == 0u,
+		"IsrRing needs a power-of-two size of at most 128.");
+
+	/** Producer side.  Returns false, counting a drop, if the ring is full. */
+	bool push(const T& item) {
+		uint8_t head = head_;
+		if(static_cast<uint8_t>(head - tail_) == Size) {
+			if(dropped_ != static_cast<Counter>(~Counter(0))) {
+				dropped_ = dropped_ + 1u;
+			}
+			return false;
+		}
+		items_[head & mask] = item;
+		head_ = head + 1u;
+		return true;
+	}
+
+	/** Consumer side.  Takes the oldest item; returns false if there is none. */
+	bool pop(T& item) {
+		uint8_t tail = tail_;
+		if(tail == head_) {
+			return false;
+		}
+		item = items_[tail & mask];
+		tail_ = tail + 1u;
+		return true;
+	}
+
+	/** Consumer side.  Number of items waiting. */
+	uint8_t size() const {
+		return head_ - tail_;
+	}
+
+	/** Consumer side.  Discard everything waiting. */
+	void clear() {
+		tail_ = head_;
+	}
+
+	/** Number of items dropped since the last call; resets the count. */
+	Counter take_dropped() {
+		uint8_t oldSREG = SREG;
+		cli();
+		Counter count = dropped_;
+		dropped_ = 0u;
+		SREG = oldSREG;
+		return count;
+	}
+
+private:
+
+	static constexpr uint8_t mask = Size - 1u;
+
+	T items_[Size];
+	volatile uint8_t head_ = 0u;
+	volatile uint8_t tail_ = 0u;
+	volatile Counter dropped_ = 0u;
+};
+
+} /* namespace ino */
+
+#endif /* INO_ISR_RING_H */
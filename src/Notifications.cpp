@@ -0,0 +1,75 @@
+#include "Notifications.h"
+#include "BinaryCommand.h"
+
+namespace ino {
+
+void notify_pin_change(const PinEvent& event) {
+	const CheckedPin& pin = all_pins[event.pin];
+	if(active_protocol() == Protocol::Binary) {
+		const uint8_t payload[] = {
+			static_cast<uint8_t>(NotificationKind::PinChange),
+			static_cast<uint8_t>(pin.number()),
+			static_cast<uint8_t>(event.level),
+			static_cast<uint8_t>(event.time),
+			static_cast<uint8_t>(event.time >> 8u),
+			static_cast<uint8_t>(event.time >> 16u),
+			static_cast<uint8_t>(event.time >> 24u)
+		};
+		write_frame(Serial, FrameStatus::Notification, Span<const uint8_t>(payload, sizeof(payload)));
+		return;
+	}
+	Serial.print(F("!PIN "));
+	Serial.print(pin.name());
+	Serial.print(' ');
+	Serial.print(event.level == LogicLevel::High ? 1 : 0);
+	Serial.print(' ');
+	Serial.println(event.time);
+}
+
+void notify_telemetry(Span<const TelemetrySample> samples) {
+	if(active_protocol() == Protocol::Binary) {
+		uint8_t payload[1u + 3u * max_subscriptions];
+		std::size_t size = 0u;
+		payload[size++] = static_cast<uint8_t>(NotificationKind::Telemetry);
+		for(const TelemetrySample& sample: samples) {
+			payload[size++] = sample.id;
+			payload[size++] = static_cast<uint8_t>(sample.value);
+			payload[size++] = static_cast<uint8_t>(static_cast<uint16_t>(sample.value) >> 8u);
+		}
+		write_frame(Serial, FrameStatus::Notification, Span<const uint8_t>(payload, size));
+		return;
+	}
+	Serial.print(F("!SUB"));
+	for(const TelemetrySample& sample: samples) {
+		Serial.print(' ');
+		Serial.print(sample.id);
+		Serial.print('=');
+		Serial.print(sample.value);
+	}
+	Serial.println();
+}
+
+void notify_comparator(const ComparatorEvent& event) {
+	const CheckedPin& pin = comparator_pin();
+	if(active_protocol() == Protocol::Binary) {
+		const uint8_t payload[] = {
+			static_cast<uint8_t>(NotificationKind::Comparator),
+			static_cast<uint8_t>(pin.number()),
+			static_cast<uint8_t>(event.level),
+			static_cast<uint8_t>(event.time),
+			static_cast<uint8_t>(event.time >> 8u),
+			static_cast<uint8_t>(event.time >> 16u),
+			static_cast<uint8_t>(event.time >> 24u)
+		};
+		write_frame(Serial, FrameStatus::Notification, Span<const uint8_t>(payload, sizeof(payload)));
+		return;
+	}
+	Serial.print(F("!CMP "));
+	Serial.print(pin.name());
+	Serial.print(' ');
+	Serial.print(event.level == LogicLevel::High ? 1 : 0);
+	Serial.print(' ');
+	Serial.println(event.time);
+}
+
+} /* namespace ino */
@@ -0,0 +1,44 @@
+#ifndef INO_NOTIFICATIONS_H
+#define INO_NOTIFICATIONS_H
+
+#include <Arduino.h>
+#include "PinEvents.h"
+#include "Subscriptions.h"
+#include "AnalogComparator.h"
+#include "Span.h"
+
+namespace ino {
+
+/**
+ * Unsolicited messages to the host, sent between replies.  In the text protocol a
+ * notification is a line starting with '!', which no reply ever does:
+ *
+ *         !PIN <pin> <level> <millis>
+ *         !SUB <id>=<value> [<id>=<value> ...]
+ *         !CMP <pin> <level> <micros>
+ *
+ * In the binary protocol it is a frame with status FrameStatus::Notification whose
+ * payload starts with a NotificationKind:
+ *
+ *         0x01 pin change         <pin> <level> <uint32 millis>
+ *         0x02 telemetry          (<id> <int16 value>) ...
+ *         0x03 comparator         <pin> <level> <uint32 micros>
+ */
+enum class NotificationKind: uint8_t {
+	PinChange = 0x01u,
+	Telemetry = 0x02u,
+	Comparator = 0x03u
+};
+
+/** Push a settled change of a watched pin to the host. */
+void notify_pin_change(const PinEvent& event);
+
+/** Push the samples taken for subscriptions in one tick, as a single notification. */
+void notify_telemetry(Span<const TelemetrySample> samples);
+
+/** Push a crossing of the comparator threshold to the host; level 1 is above it. */
+void notify_comparator(const ComparatorEvent& event);
+
+} /* namespace ino */
+
+#endif /* INO_NOTIFICATIONS_H */
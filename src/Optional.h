@@ -69,11 +69,11 @@ struct Optional {
 	}
 
 	constexpr const T& value() const {
-		return *value_;
+		return value_;
 	}
 
 	constexpr T& value() {
-		return *value_;
+		return value_;
 	}
 
 	constexpr const T& operator*() const {
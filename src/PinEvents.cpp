@@ -0,0 +1,223 @@
+#include "PinEvents.h"
+#include <avr/interrupt.h>
+#include "IsrRing.h"
+
+namespace ino {
+
+struct PinEdge {
+	uint32_t time;
+	uint8_t pin;
+};
+
+// Raw edges, written by interrupt handlers and read by poll_pin_event().
+static IsrRing<PinEdge, 8u> edge_queue;
+// Pins with an edge that did not fit in the queue, one bit per pin in 'all_pins'.
+static volatile uint32_t missed_pins = 0u;
+
+// Settled events waiting for the 'events' command; only touched by the main loop.
+static constexpr uint8_t event_log_size = 16u;
+static PinEvent event_log[event_log_size];
+static uint8_t log_head = 0u;
+static uint8_t log_tail = 0u;
+static uint8_t evicted_events = 0u;
+
+static_assert((event_log_size & (event_log_size - 1u)) == 0u);
+static_assert(all_pins.size() <= 32u);
+
+// Debouncer state, one bit (or entry) per pin in 'all_pins'.
+static uint32_t settling = 0u;
+static uint32_t stable_levels = 0u;
+static uint32_t last_edge[all_pins.size()];
+
+// Pins watched with pin change interrupts, one bit per pin in 'all_pins', and the last
+// input levels seen by the PCINT handler of each port (indexed by Port).
+static uint32_t watched = 0u;
+static uint8_t port_levels[3] = {0u, 0u, 0u};
+
+static void capture_edge(uint8_t index) {
+	if(not edge_queue.push(PinEdge{millis(), index})) {
+		// The pin still gets debounced; poll_pin_event() reads its level when it settles.
+		missed_pins = missed_pins | (1ul << index);
+	}
+}
+
+void capture_pin_edge(const CheckedPin& pin) {
+	capture_edge(static_cast<uint8_t>(pin.index()));
+}
+
+static volatile uint8_t& pin_change_mask(Port port) {
+	switch(port) {
+	case Port::B:
+		return PCMSK0;
+	case Port::C:
+		return PCMSK1;
+	default:
+		return PCMSK2;
+	}
+}
+
+static uint8_t port_input(Port port) {
+	switch(port) {
+	case Port::B:
+		return PINB;
+	case Port::C:
+		return PINC;
+	default:
+		return PIND;
+	}
+}
+
+static uint8_t pin_change_enable_bit(Port port) {
+	switch(port) {
+	case Port::B:
+		return _BV(PCIE0);
+	case Port::C:
+		return _BV(PCIE1);
+	default:
+		return _BV(PCIE2);
+	}
+}
+
+/** Capture an edge for each watched pin of 'port' that differs from the last snapshot. */
+static void port_changed(Port port, uint8_t levels, uint8_t first_index) {
+	uint8_t& last = port_levels[static_cast<uint8_t>(port)];
+	uint8_t changed = (levels ^ last) & pin_change_mask(port);
+	last = levels;
+	for(uint8_t i = first_index; changed != 0u; ++i, changed >>= 1u) {
+		if(changed & 1u) {
+			capture_edge(i);
+		}
+	}
+}
+
+ISR(PCINT0_vect) {
+	port_changed(Port::B, PINB, 8u);
+}
+
+ISR(PCINT1_vect) {
+	port_changed(Port::C, PINC, 14u);
+}
+
+ISR(PCINT2_vect) {
+	port_changed(Port::D, PIND, 0u);
+}
+
+PinStatus watch_pin(const CheckedPin& pin) {
+	if(pin.number() == 0 or pin.number() == 1) {
+		return PinStatus::BadPinKind;
+	}
+	track_pin_events(pin);
+	Port port = pin.port();
+	uint8_t oldSREG = SREG;
+	cli();
+	watched |= 1ul << pin.index();
+	port_levels[static_cast<uint8_t>(port)] = port_input(port);
+	pin_change_mask(port) |= pin.bit_mask();
+	PCIFR = pin_change_enable_bit(port);
+	PCICR |= pin_change_enable_bit(port);
+	SREG = oldSREG;
+	return PinStatus::Good;
+}
+
+void unwatch_pin(const CheckedPin& pin) {
+	Port port = pin.port();
+	uint8_t oldSREG = SREG;
+	cli();
+	watched &= ~(1ul << pin.index());
+	pin_change_mask(port) &= ~pin.bit_mask();
+	if(pin_change_mask(port) == 0u) {
+		PCICR &= ~pin_change_enable_bit(port);
+	}
+	SREG = oldSREG;
+}
+
+bool pin_watched(uint8_t index) {
+	return watched & (1ul << index);
+}
+
+static void log_pin_event(const PinEvent& event) {
+	if(static_cast<uint8_t>(log_head - log_tail) == event_log_size) {
+		// Keep the newest events; the host can tell from the count that some were lost.
+		++log_tail;
+		if(evicted_events != 0xFFu) {
+			++evicted_events;
+		}
+	}
+	event_log[log_head++ & (event_log_size - 1u)] = event;
+}
+
+void track_pin_events(const CheckedPin& pin) {
+	uint32_t bit = 1ul << pin.index();
+	settling &= ~bit;
+	if(pin.digital_read() == LogicLevel::High) {
+		stable_levels |= bit;
+	} else {
+		stable_levels &= ~bit;
+	}
+}
+
+bool poll_pin_event(PinEvent& event) {
+	// Feed the raw edges to the debouncer; each one restarts its pin's settling time.
+	PinEdge edge;
+	while(edge_queue.pop(edge)) {
+		settling |= 1ul << edge.pin;
+		last_edge[edge.pin] = edge.time;
+	}
+	uint32_t now = millis();
+	if(missed_pins != 0u) {
+		uint8_t oldSREG = SREG;
+		cli();
+		uint32_t missed = missed_pins;
+		missed_pins = 0u;
+		SREG = oldSREG;
+		settling |= missed;
+		for(uint8_t i = 0u; i < all_pins.size(); ++i) {
+			if(missed & (1ul << i)) {
+				last_edge[i] = now;
+			}
+		}
+	}
+	if(settling == 0u) {
+		return false;
+	}
+	for(uint8_t i = 0u; i < all_pins.size(); ++i) {
+		uint32_t bit = 1ul << i;
+		if(not (settling & bit) or now - last_edge[i] < debounce_ms) {
+			continue;
+		}
+		settling &= ~bit;
+		// The pin itself rather than the last queued edge, which may not be its last edge.
+		uint32_t level = all_pins[i].digital_read() == LogicLevel::High ? bit : 0u;
+		if((stable_levels ^ level) & bit) {
+			stable_levels ^= bit;
+			event = PinEvent{
+				last_edge[i],
+				i,
+				(stable_levels & bit) ? LogicLevel::High : LogicLevel::Low
+			};
+			log_pin_event(event);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool next_logged_pin_event(PinEvent& event) {
+	if(log_tail == log_head) {
+		return false;
+	}
+	event = event_log[log_tail++ & (event_log_size - 1u)];
+	return true;
+}
+
+uint8_t take_dropped_pin_events() {
+	uint8_t count = evicted_events;
+	evicted_events = 0u;
+	return count;
+}
+
+uint8_t take_missed_pin_edges() {
+	return edge_queue.take_dropped();
+}
+
+} /* namespace ino */
@@ -0,0 +1,61 @@
+#ifndef INO_PIN_EVENTS_H
+#define INO_PIN_EVENTS_H
+
+#include <Arduino.h>
+#include "Pins.h"
+
+namespace ino {
+
+/** A settled change of level on one of 'all_pins'. */
+struct PinEvent {
+	/** millis() at the last edge before the pin settled. */
+	uint32_t time;
+	/** Index of the pin in 'all_pins'. */
+	uint8_t pin;
+	LogicLevel level;
+};
+
+/** How long a pin must stay at one level before an edge counts. */
+inline constexpr uint8_t debounce_ms = 10u;
+
+/**
+ * Record a raw edge on 'pin'.  Meant to be called from a pin interrupt handler: it only
+ * timestamps the edge and pushes it into a lock-free ring, which poll_pin_event() drains.
+ * The level is read from the pin once it has settled, so a full ring loses no changes.
+ */
+void capture_pin_edge(const CheckedPin& pin);
+
+/** Take the current level of 'pin' as settled, so that the next change is reported. */
+void track_pin_events(const CheckedPin& pin);
+
+/**
+ * Capture changes of 'pin' with its pin change interrupt (PCINT).  Returns
+ * PinStatus::BadPinKind for pins 0 and 1, which belong to the serial port.
+ */
+PinStatus watch_pin(const CheckedPin& pin);
+
+void unwatch_pin(const CheckedPin& pin);
+
+/** Whether the pin with the given index in 'all_pins' is watched. */
+[[nodiscard]]
+bool pin_watched(uint8_t index);
+
+/**
+ * Debounce the captured edges.  Returns true and fills 'event' for each pin that has
+ * settled at a new level; the event is also kept for next_logged_pin_event().  Call from
+ * the main loop until it returns false.
+ */
+bool poll_pin_event(PinEvent& event);
+
+/** Take the oldest event from the log of settled events.  Returns false if it is empty. */
+bool next_logged_pin_event(PinEvent& event);
+
+/** Number of events pushed out of the full log since the last call; resets the count. */
+uint8_t take_dropped_pin_events();
+
+/** Number of raw edges that found the ring full since the last call; resets the count. */
+uint8_t take_missed_pin_edges();
+
+} /* namespace ino */
+
+#endif /* INO_PIN_EVENTS_H */
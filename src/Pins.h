@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "ino_assert.h"
 #include "Array.h"
+#include "Adc.h"
 #include <utility>
 #include <bitset>
 
@@ -26,11 +27,32 @@ enum class PinMode: int {
 	InputPullup = INPUT_PULLUP
 };
 
+// I/O ports of the ATmega328P.
+enum class Port: uint8_t {
+	B,
+	C,
+	D
+};
+
 enum class PinStatus {
 	Good,
 	BadPinMode,
 	BadPinKind,
 	BadAnalogWriteValue,
+	AdcBusy,
+	BadResolution,
+};
+
+/** Where CheckedPin::analog_read() gets its value from. */
+enum class AnalogRead: uint8_t {
+	// The newest result the ADC has for the pin.
+	Latest,
+	// A conversion started for this read.
+	Fresh,
+	// Like Fresh, with the CPU in the ADC Noise Reduction sleep mode (see adc_oversample()).
+	Asleep,
+	// The latest output of the pin's filter (see adc_set_filter()).
+	Filtered
 };
 
 /**
@@ -99,7 +121,8 @@ struct CheckedPin {
 		case 7:  return PinKind::Digital;
 		case 8:  return PinKind::Digital;
 		case 9:  return PinKind::Digital;
-		case 10: return PinKind::DigitalPWM;
+		// Timer1 is reserved for the stepper, so pins 9 and 10 have no PWM.
+		case 10: return PinKind::Digital;
 		case 11: return PinKind::DigitalPWM;
 		case 12: return PinKind::Digital;
 		case 13: return PinKind::Digital;
@@ -148,21 +171,32 @@ struct CheckedPin {
 		return index() >= 0 and index() <= A7;
 	}
 
-	void set_mode(PinMode mode) const {
-		switch(mode) {
-		default:
-			/* shouldn't be reachable */
-			UNREACHABLE();
-		case PinMode::InputPullup:
-			is_pullup_[index()] = true;
-		case PinMode::Input:
-			pinmodes_[index()] = true;
-			break;
-		case PinMode::Output:
-			is_pullup_[index()] = false;
-			pinmodes_[index()] = false;
-			break;
+	/** The hardware port the pin belongs to (Arduino Uno layout). */
+	[[nodiscard]]
+	constexpr Port port() const {
+		if(number() < 8) {
+			return Port::D;
+		} else if(number() < 14) {
+			return Port::B;
+		} else {
+			return Port::C;
+		}
+	}
+
+	/** The pin's bit within the registers of its port. */
+	[[nodiscard]]
+	constexpr uint8_t bit_mask() const {
+		if(number() < 8) {
+			return static_cast<uint8_t>(1u << number());
+		} else if(number() < 14) {
+			return static_cast<uint8_t>(1u << (number() - 8));
+		} else {
+			return static_cast<uint8_t>(1u << (number() - A0));
 		}
+	}
+
+	void set_mode(PinMode mode) const {
+		record_mode(mode);
 		pinMode(number(), static_cast<int>(mode));
 	}
 
@@ -196,15 +230,43 @@ struct CheckedPin {
 		return PinStatus::Good;
 	}
 
+	/**
+	 * Read the pin in 'bits' of resolution; 0 means the resolution adc_configure() set.
+	 * Up to adc_max_extra_bits more bits are made by oversampling, which always converts
+	 * the pin afresh.
+	 */
 	[[nodiscard]]
-	std::pair<int, PinStatus> analog_read() const {
+	std::pair<int, PinStatus> analog_read(AnalogRead how = AnalogRead::Latest, uint8_t bits = 0u) const {
 		if(kind() != PinKind::Analog) {
 			return {-1, PinStatus::BadPinKind};
 		}
 		if(mode() == PinMode::Output) {
 			return {-1, PinStatus::BadPinMode};
 		}
-		int val = analogRead(number());
+		uint8_t base_bits = adc_config().bits;
+		if(bits == 0u) {
+			bits = base_bits;
+		}
+		if(bits < base_bits or bits > base_bits + adc_max_extra_bits) {
+			return {-1, PinStatus::BadResolution};
+		}
+		uint8_t channel = static_cast<uint8_t>(number() - A0);
+		int val = 0;
+		if(how == AnalogRead::Filtered) {
+			if(bits != base_bits) {
+				return {-1, PinStatus::BadResolution};
+			}
+			val = adc_read_filtered(channel);
+		} else if(how == AnalogRead::Asleep or bits != base_bits) {
+			val = adc_oversample(channel, bits - base_bits, how == AnalogRead::Asleep);
+		} else if(how == AnalogRead::Fresh) {
+			val = adc_convert(channel);
+		} else {
+			val = adc_read(channel);
+		}
+		if(val == adc_busy) {
+			return {-1, PinStatus::AdcBusy};
+		}
 		return {val, PinStatus::Good};
 	}
 
@@ -223,6 +285,25 @@ struct CheckedPin {
 		return PinStatus::Good;
 	}
 
+protected:
+
+	void record_mode(PinMode mode) const {
+		switch(mode) {
+		default:
+			/* shouldn't be reachable */
+			UNREACHABLE();
+		case PinMode::InputPullup:
+			is_pullup_[index()] = true;
+		case PinMode::Input:
+			pinmodes_[index()] = true;
+			break;
+		case PinMode::Output:
+			is_pullup_[index()] = false;
+			pinmodes_[index()] = false;
+			break;
+		}
+	}
+
 private:
 
 	constexpr CheckedPin(int p):
@@ -259,8 +340,192 @@ inline constexpr auto all_pins = ino::Array{
 	CheckedPin::from_pin_number<A5>()
 };
 
+/**
+ * A pin whose number is known at compile time.  Behaves like the equivalent CheckedPin,
+ * but the port registers and bit mask are resolved at compile time, so mode changes,
+ * reads and writes compile down to single sbi/cbi/sbis instructions instead of going
+ * through pinMode()/digitalRead()/digitalWrite() and their table lookups.
+ */
+template <int Number>
+struct StaticPin: CheckedPin {
+
+	static constexpr Port port_value = CheckedPin::from_pin_number<Number>().port();
+	static constexpr uint8_t mask = CheckedPin::from_pin_number<Number>().bit_mask();
+
+	constexpr StaticPin():
+		CheckedPin(CheckedPin::from_pin_number<Number>())
+	{
+		
+	}
+
+	void set_mode(PinMode mode) const {
+		record_mode(mode);
+		switch(mode) {
+		case PinMode::Input:
+			mode_register() &= ~mask;
+			output_register() &= ~mask;
+			break;
+		case PinMode::InputPullup:
+			mode_register() &= ~mask;
+			output_register() |= mask;
+			break;
+		case PinMode::Output:
+			mode_register() |= mask;
+			break;
+		}
+	}
+
+	[[nodiscard]]
+	LogicLevel digital_read() const {
+		turn_off_pwm();
+		if(input_register() & mask) {
+			return LogicLevel::High;
+		}
+		return LogicLevel::Low;
+	}
+
+	[[nodiscard]]
+	PinStatus digital_write(LogicLevel level) const {
+		if(mode() != PinMode::Output) {
+			return PinStatus::BadPinMode;
+		}
+		turn_off_pwm();
+		if(level == LogicLevel::High) {
+			output_register() |= mask;
+		} else {
+			output_register() &= ~mask;
+		}
+		return PinStatus::Good;
+	}
+
+	/** The PORTx register holding this pin's output bit. */
+	static volatile uint8_t& output_register() {
+		if constexpr(port_value == Port::B) {
+			return PORTB;
+		} else if constexpr(port_value == Port::C) {
+			return PORTC;
+		} else {
+			return PORTD;
+		}
+	}
+
+private:
+
+	static volatile uint8_t& input_register() {
+		if constexpr(port_value == Port::B) {
+			return PINB;
+		} else if constexpr(port_value == Port::C) {
+			return PINC;
+		} else {
+			return PIND;
+		}
+	}
+
+	static volatile uint8_t& mode_register() {
+		if constexpr(port_value == Port::B) {
+			return DDRB;
+		} else if constexpr(port_value == Port::C) {
+			return DDRC;
+		} else {
+			return DDRD;
+		}
+	}
+
+	// Disconnect the pin from its PWM timer, as digitalRead()/digitalWrite() do.
+	static void turn_off_pwm() {
+		if constexpr(Number == 3) {
+			TCCR2A &= ~_BV(COM2B1);
+		} else if constexpr(Number == 5) {
+			TCCR0A &= ~_BV(COM0B1);
+		} else if constexpr(Number == 6) {
+			TCCR0A &= ~_BV(COM0A1);
+		} else if constexpr(Number == 9) {
+			TCCR1A &= ~_BV(COM1A1);
+		} else if constexpr(Number == 10) {
+			TCCR1A &= ~_BV(COM1B1);
+		} else if constexpr(Number == 11) {
+			TCCR2A &= ~_BV(COM2A1);
+		}
+	}
+};
+
 template <int PinNumber>
-inline constexpr CheckedPin pin = CheckedPin::from_pin_number<PinNumber>();
+inline constexpr StaticPin<PinNumber> pin = StaticPin<PinNumber>();
+
+/**
+ * A set of pins, grouped by hardware port, that are read or driven together.  write()
+ * and read() touch every port once, inside a single critical section, so all of the
+ * outputs change (or all of the inputs are sampled) at the same time.
+ *
+ * @note Like digital_write(), write() expects the pins to be in OUTPUT mode.  Unlike
+ *       digital_write(), it does not disconnect pins from a PWM timer.
+ */
+struct PinSet {
+
+	constexpr PinSet() = default;
+
+	/** Add a pin to the set, along with the level write() should drive it to. */
+	void add(const CheckedPin& pin, LogicLevel level = LogicLevel::Low) {
+		auto port = static_cast<uint8_t>(pin.port());
+		masks_[port] |= pin.bit_mask();
+		if(level == LogicLevel::High) {
+			levels_[port] |= pin.bit_mask();
+		} else {
+			levels_[port] &= ~pin.bit_mask();
+		}
+	}
+
+	[[nodiscard]]
+	bool contains(const CheckedPin& pin) const {
+		return masks_[static_cast<uint8_t>(pin.port())] & pin.bit_mask();
+	}
+
+	/** The level of the pin as last added, or as sampled by read(). */
+	[[nodiscard]]
+	LogicLevel level(const CheckedPin& pin) const {
+		if(levels_[static_cast<uint8_t>(pin.port())] & pin.bit_mask()) {
+			return LogicLevel::High;
+		}
+		return LogicLevel::Low;
+	}
+
+	/** Drive every pin in the set to its level at once. */
+	void write() const {
+		uint8_t oldSREG = SREG;
+		cli();
+		if(masks_[static_cast<uint8_t>(Port::B)]) {
+			PORTB = (PORTB & ~masks_[static_cast<uint8_t>(Port::B)]) | levels_[static_cast<uint8_t>(Port::B)];
+		}
+		if(masks_[static_cast<uint8_t>(Port::C)]) {
+			PORTC = (PORTC & ~masks_[static_cast<uint8_t>(Port::C)]) | levels_[static_cast<uint8_t>(Port::C)];
+		}
+		if(masks_[static_cast<uint8_t>(Port::D)]) {
+			PORTD = (PORTD & ~masks_[static_cast<uint8_t>(Port::D)]) | levels_[static_cast<uint8_t>(Port::D)];
+		}
+		SREG = oldSREG;
+	}
+
+	/** Sample every pin in the set at once; the levels are available through level(). */
+	[[nodiscard]]
+	PinSet read() const {
+		PinSet sample = *this;
+		uint8_t oldSREG = SREG;
+		cli();
+		uint8_t b = PINB;
+		uint8_t c = PINC;
+		uint8_t d = PIND;
+		SREG = oldSREG;
+		sample.levels_[static_cast<uint8_t>(Port::B)] = b & masks_[static_cast<uint8_t>(Port::B)];
+		sample.levels_[static_cast<uint8_t>(Port::C)] = c & masks_[static_cast<uint8_t>(Port::C)];
+		sample.levels_[static_cast<uint8_t>(Port::D)] = d & masks_[static_cast<uint8_t>(Port::D)];
+		return sample;
+	}
+
+private:
+	// Indexed by Port.
+	uint8_t masks_[3] = {0u, 0u, 0u};
+	uint8_t levels_[3] = {0u, 0u, 0u};
+};
 
 } /* namespace ino */
 
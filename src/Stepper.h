@@ -1,110 +1,589 @@
 #ifndef INO_STEPPER_H
 #define INO_STEPPER_H
 
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include "Array.h"
+#include "Pins.h"
 
 namespace ino {
 
-template <uint8_t N, int E1, int E2, int M1, int M2>
+enum class Direction: uint8_t {
+	Forward,
+	Backward
+};
+
+namespace detail {
+
+constexpr uint16_t isqrt(uint32_t value) {
+	uint32_t root = 0u;
+	uint32_t bit = 1ul << 30u;
+	while(bit > value) {
+		bit >>= 2u;
+	}
+	while(bit != 0u) {
+		if(value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1u) + bit;
+		} else {
+			root >>= 1u;
+		}
+		bit >>= 2u;
+	}
+	return static_cast<uint16_t>(root);
+}
+
+} /* namespace detail */
+
+/**
+ * Step sequences.  Each state is a combination of the coil bits below: the polarity
+ * (E1/E2) and the enable (M1/M2) of each of the two coils.
+ */
+inline constexpr uint8_t coil_a_forward = 0x01u;
+inline constexpr uint8_t coil_b_forward = 0x02u;
+inline constexpr uint8_t coil_a_on      = 0x04u;
+inline constexpr uint8_t coil_b_on      = 0x08u;
+
+/** Both coils always energized; full torque. */
+struct FullStep {
+	static constexpr uint8_t states[] = {
+		coil_a_on | coil_b_on,
+		coil_a_on | coil_b_on | coil_a_forward,
+		coil_a_on | coil_b_on | coil_a_forward | coil_b_forward,
+		coil_a_on | coil_b_on | coil_b_forward
+	};
+};
+
+/** Alternates between one and two energized coils; twice the positions per turn. */
+struct HalfStep {
+	static constexpr uint8_t states[] = {
+		coil_a_on | coil_b_on,
+		coil_b_on,
+		coil_a_on | coil_b_on | coil_a_forward,
+		coil_a_on | coil_a_forward,
+		coil_a_on | coil_b_on | coil_a_forward | coil_b_forward,
+		coil_b_on | coil_b_forward,
+		coil_a_on | coil_b_on | coil_b_forward,
+		coil_a_on
+	};
+};
+
+/** One coil energized at a time; less torque and current than FullStep. */
+struct WaveDrive {
+	static constexpr uint8_t states[] = {
+		coil_b_on,
+		coil_a_on | coil_a_forward,
+		coil_b_on | coil_b_forward,
+		coil_a_on
+	};
+};
+
+namespace detail {
+
+template <class Sequence, int E1, int E2, int M1, int M2>
+constexpr FlashArray<uint8_t, sizeof(Sequence::states)> make_step_table() {
+	FlashArray<uint8_t, sizeof(Sequence::states)> table{};
+	for(std::size_t i = 0u; i < sizeof(Sequence::states); ++i) {
+		uint8_t state = Sequence::states[i];
+		uint8_t bits = 0u;
+		bits |= (state & coil_a_forward) ? StaticPin<E1>::mask : 0u;
+		bits |= (state & coil_b_forward) ? StaticPin<E2>::mask : 0u;
+		bits |= (state & coil_a_on) ? StaticPin<M1>::mask : 0u;
+		bits |= (state & coil_b_on) ? StaticPin<M2>::mask : 0u;
+		table.private_data_[i] = bits;
+	}
+	return table;
+}
+
+} /* namespace detail */
+
+/** The states of 'Sequence' as the bits to write to the port holding E1, E2, M1 and M2. */
+template <class Sequence, int E1, int E2, int M1, int M2>
+[[gnu::progmem]]
+inline constexpr auto step_table = detail::make_step_table<Sequence, E1, E2, M1, M2>();
+
+/** What a Stepper needs to pick up where it left off after a reset. */
+struct StepperState {
+	uint8_t position;
+	/** Index into the step sequence, so the coils come back up in the same phase. */
+	uint8_t state;
+};
+
+/** Stepper memory that remembers nothing; the motor starts at position 0. */
+struct NoMemory {
+	bool load(StepperState&) { return false; }
+	void save(const StepperState&) {}
+};
+
+/** A queued stepper move, as reported by Stepper::queued_move(). */
+struct StepperMove {
+	Direction direction;
+	uint8_t steps;
+	/** Cruise speed, in steps per second. */
+	uint16_t speed;
+};
+
+/**
+ * A two-wire stepper motor with 'N' positions.  Steps are issued from the Timer1
+ * compare-match A interrupt, so move_to() returns immediately and the motor runs in the
+ * background.  The owner must forward TIMER1_COMPA_vect to timer_interrupt(); as a
+ * consequence, there can only be one Stepper in a program and Timer1 is not available
+ * for PWM.
+ *
+ * Moves follow a trapezoidal speed profile: the step interval shrinks from the start
+ * interval down to the cruise interval and grows back before the target.  The interval
+ * for each step is derived from the previous one with the recurrence from D. Austin,
+ * "Generate stepper-motor speed profiles in real time" (c' = c - 2c / (4n + 1)), in
+ * 24.8 fixed point, so the interrupt needs a single integer division per step.
+ *
+ * Up to 'QueueSize' further moves can be queued with enqueue() and enqueue_to(); they
+ * run back to back, and the motor only slows down where it has to stop or turn around.
+ *
+ * 'Sequence' selects the coil states stepped through (FullStep, HalfStep or WaveDrive).
+ * E1, E2, M1 and M2 must be on the same port, so that each state is applied with a
+ * single write and both coils change together.
+ *
+ * 'Memory' stores the position whenever the motor comes to rest, and begin() restores
+ * it, e.g. an EepromRecord<StepperState, ...> to survive resets.
+ */
+template <
+	uint8_t N, int E1, int E2, int M1, int M2,
+	class Sequence = FullStep, uint8_t QueueSize = 8u, class Memory = NoMemory
+>
 struct Stepper {
 
+	static_assert(
+		StaticPin<E1>::port_value == StaticPin<E2>::port_value
+			and StaticPin<E1>::port_value == StaticPin<M1>::port_value
+			and StaticPin<E1>::port_value == StaticPin<M2>::port_value,
+		"The stepper pins must all be on the same port."
+	);
+
+	static constexpr uint8_t sequence_length = sizeof(Sequence::states);
+
+	static_assert((sequence_length & (sequence_length - 1u)) == 0u,
+		"The length of a step sequence must be a power of two.");
+
+	static_assert(QueueSize != 0u and QueueSize <= 128u and (QueueSize & (QueueSize - 1u)) == 0u,
+		"QueueSize must be a power of two no larger than 128.");
+
+	static constexpr uint32_t timer_frequency = F_CPU / 64ul;
+
+	/** Slowest time between two steps, used from a standstill, in Timer1 ticks (4ms). */
+	static constexpr uint16_t start_interval = static_cast<uint16_t>(timer_frequency / 1000ul * 4ul);
+
+	static constexpr uint16_t min_speed = static_cast<uint16_t>(timer_frequency / start_interval);
+	static constexpr uint16_t max_speed = 4000u;
+	static constexpr uint16_t default_speed = 1000u;
+	static constexpr uint16_t default_acceleration = 20000u;
+
 	Stepper():
 		state_(0),
 		position_(0)
 	{
-	
+
 	}
 
 	void begin() {
-		pinMode(E1, OUTPUT);
-		pinMode(E2, OUTPUT);
-		pinMode(M1, OUTPUT);
-		pinMode(M2, OUTPUT);
-		digitalWrite(E1, LOW);
-		digitalWrite(E2, LOW);
-		digitalWrite(M1, HIGH);
-		digitalWrite(M2, HIGH);
+		StepperState saved{};
+		if(memory_.load(saved) and saved.position < N) {
+			position_ = saved.position;
+			state_ = saved.state;
+		}
+		uint8_t oldSREG = SREG;
+		cli();
+		publish();
+		pin<E1>.set_mode(PinMode::Output);
+		pin<E2>.set_mode(PinMode::Output);
+		pin<M1>.set_mode(PinMode::Output);
+		pin<M2>.set_mode(PinMode::Output);
+		// CTC mode on OCR1A, clock/64, interrupt left disabled until a move starts.
+		TIMSK1 &= ~_BV(OCIE1A);
+		TCCR1A = 0u;
+		TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+		OCR1A = start_interval - 1u;
+		SREG = oldSREG;
+		set_cruise_speed(default_speed);
+		set_acceleration(default_acceleration);
 	}
 
-	void forward_step() {
-		++position_;
-		position_ %= N;
-		++state_;
-		publish();
+	Memory& memory() {
+		return memory_;
 	}
 
-	void backward_step() {
-		if(position() == 0u) {
-			position_ = 100u;
+	/** Set the top speed, in steps per second; clamped to [min_speed, max_speed]. */
+	void set_cruise_speed(uint16_t steps_per_second) {
+		default_interval_ = interval_for_speed(steps_per_second);
+	}
+
+	/** The cruise speed used by move_to() and by moves queued without a speed. */
+	uint16_t cruise_speed() const {
+		return speed_for_interval(default_interval_);
+	}
+
+	/** Set the acceleration and deceleration, in steps per second squared. */
+	void set_acceleration(uint16_t steps_per_second2) {
+		if(steps_per_second2 == 0u) {
+			steps_per_second2 = 1u;
 		}
-		--position_;
-		--state_;
-		publish();
+		// First interval of a constant-acceleration ramp, c0 = 0.676 * f * sqrt(2 / a).
+		uint32_t interval = ((timer_frequency * 956ul / 1000ul) << 8u) / detail::isqrt(steps_per_second2);
+		uint8_t oldSREG = SREG;
+		cli();
+		first_interval_ = interval;
+		SREG = oldSREG;
 	}
 
 	uint8_t position() const {
 		return position_;
 	}
 
+	/** The position the current move ends at; equal to position() when stopped. */
+	uint8_t target() const {
+		uint8_t oldSREG = SREG;
+		cli();
+		uint8_t pos = advance(position_, direction_, steps_remaining_);
+		SREG = oldSREG;
+		return pos;
+	}
+
+	/** The position the last queued move ends at. */
+	uint8_t planned_position() const {
+		uint8_t oldSREG = SREG;
+		cli();
+		uint8_t pos = planned_position_unlocked();
+		SREG = oldSREG;
+		return pos;
+	}
+
+	bool moving() const {
+		return steps_remaining_ != 0u;
+	}
+
+	/**
+	 * Start moving towards 'pos' in the given direction.  Replaces the move in progress
+	 * and drops any queued moves.
+	 */
+	void move_to(uint8_t pos, Direction direction) {
+		uint8_t oldSREG = SREG;
+		cli();
+		queue_head_ = queue_tail_;
+		start_segment(Segment{direction, distance(position_, pos % N, direction), default_interval_});
+		SREG = oldSREG;
+	}
+
+	/** Start moving towards 'pos' along the shorter way around. */
+	void move_to(uint8_t pos) {
+		uint8_t oldSREG = SREG;
+		cli();
+		queue_head_ = queue_tail_;
+		start_segment(shortest_segment(position_, pos % N, default_interval_));
+		SREG = oldSREG;
+	}
+
+	/**
+	 * Queue a move of 'steps' steps in the given direction, after the moves already
+	 * queued, at 'speed' steps per second (or the cruise speed if 'speed' is 0).
+	 * Returns false if the queue is full.
+	 */
+	bool enqueue(Direction direction, uint8_t steps, uint16_t speed = 0u) {
+		uint32_t interval = speed == 0u ? default_interval_ : interval_for_speed(speed);
+		uint8_t oldSREG = SREG;
+		cli();
+		bool queued = push(Segment{direction, steps, interval});
+		SREG = oldSREG;
+		return queued;
+	}
+
+	/** Queue a move to 'pos', along the shorter way around from planned_position(). */
+	bool enqueue_to(uint8_t pos, uint16_t speed = 0u) {
+		uint32_t interval = speed == 0u ? default_interval_ : interval_for_speed(speed);
+		uint8_t oldSREG = SREG;
+		cli();
+		bool queued = push(shortest_segment(planned_position_unlocked(), pos % N, interval));
+		SREG = oldSREG;
+		return queued;
+	}
+
+	/** Number of moves waiting behind the current one. */
+	uint8_t queued() const {
+		uint8_t oldSREG = SREG;
+		cli();
+		uint8_t count = queue_tail_ - queue_head_;
+		SREG = oldSREG;
+		return count;
+	}
+
+	/** The 'index'th move waiting behind the current one; 'index' must be less than queued(). */
+	StepperMove queued_move(uint8_t index) const {
+		uint8_t oldSREG = SREG;
+		cli();
+		Segment segment = queue_[static_cast<uint8_t>(queue_head_ + index) & queue_mask];
+		SREG = oldSREG;
+		return StepperMove{segment.direction, segment.steps, speed_for_interval(segment.interval)};
+	}
+
+	/** Drop the queued moves; the current move still runs to its end. */
+	void flush() {
+		uint8_t oldSREG = SREG;
+		cli();
+		queue_head_ = queue_tail_;
+		plan_run();
+		SREG = oldSREG;
+	}
+
+	/** Abort the current move and drop the queued ones; the motor stays wherever it is. */
+	void stop() {
+		uint8_t oldSREG = SREG;
+		cli();
+		TIMSK1 &= ~_BV(OCIE1A);
+		queue_head_ = queue_tail_;
+		if(steps_remaining_ != 0u) {
+			steps_remaining_ = 0u;
+			run_steps_ = 0u;
+			remember();
+		}
+		SREG = oldSREG;
+	}
+
+	/** Move to 'pos' and wait until the motor gets there. */
 	void set_position(uint8_t pos) {
-		pos %= 100;
-		if(pos > position()) {
-			auto count = pos - position();
-			if(count < 50) {
-				while(position() != pos) {
-					forward_step();
-					delay(4);
-				}
-			} else {
-				while(position() != pos) {
-					backward_step();
-					delay(4);
-				}
-			}
+		move_to(pos);
+		while(moving()) {
+			// Wait for the timer interrupt to finish the move.
+		}
+	}
+
+	/** Must be called from TIMER1_COMPA_vect. */
+	void timer_interrupt() {
+		if(steps_remaining_ == 0u) {
+			TIMSK1 &= ~_BV(OCIE1A);
+			return;
+		}
+		if(direction_ == Direction::Forward) {
+			forward_step();
 		} else {
-			auto count = position() - pos;
-			if(count < 50) {
-				while(position() != pos) {
-					backward_step();
-					delay(4);
-				}
-			} else {
-				while(position() != pos) {
-					forward_step();
-					delay(4);
-				}
+			backward_step();
+		}
+		--run_steps_;
+		if(--steps_remaining_ == 0u) {
+			if(queue_head_ == queue_tail_) {
+				TIMSK1 &= ~_BV(OCIE1A);
+				remember();
+				return;
+			}
+			if(start_segment(queue_[queue_head_++ & queue_mask])) {
+				// Turning around; start_segment() already set up the first interval.
+				return;
 			}
 		}
+		OCR1A = next_interval() - 1u;
 	}
 
 private:
 
-	void publish() const {
-		switch(state()) {
-		case 0u:
-			digitalWrite(E1, LOW);
-			digitalWrite(E2, LOW);
-			break;
-		case 1u:
-			digitalWrite(E1, HIGH);
-			digitalWrite(E2, LOW);
-			break;
-		case 2u:
-			digitalWrite(E1, HIGH);
-			digitalWrite(E2, HIGH);
-			break;
-		case 3u:
-			digitalWrite(E1, LOW);
-			digitalWrite(E2, HIGH);
-			break;
+	struct Segment {
+		Direction direction;
+		uint8_t steps;
+		// Cruise interval, in 24.8 fixed point Timer1 ticks.
+		uint32_t interval;
+	};
+
+	static constexpr uint8_t queue_mask = QueueSize - 1u;
+
+	static uint32_t interval_for_speed(uint16_t steps_per_second) {
+		if(steps_per_second < min_speed) {
+			steps_per_second = min_speed;
+		} else if(steps_per_second > max_speed) {
+			steps_per_second = max_speed;
+		}
+		return (timer_frequency << 8u) / steps_per_second;
+	}
+
+	static uint16_t speed_for_interval(uint32_t interval) {
+		return static_cast<uint16_t>((timer_frequency << 8u) / interval);
+	}
+
+	static uint8_t advance(uint8_t pos, Direction direction, uint8_t steps) {
+		if(direction == Direction::Forward) {
+			return (pos + steps % N) % N;
 		}
+		return (pos + N - steps % N) % N;
+	}
+
+	static uint8_t distance(uint8_t from, uint8_t to, Direction direction) {
+		if(direction == Direction::Forward) {
+			return (to + N - from) % N;
+		}
+		return (from + N - to) % N;
+	}
+
+	static Segment shortest_segment(uint8_t from, uint8_t to, uint32_t interval) {
+		uint8_t forward = distance(from, to, Direction::Forward);
+		if(forward < N / 2u) {
+			return Segment{Direction::Forward, forward, interval};
+		}
+		return Segment{Direction::Backward, distance(from, to, Direction::Backward), interval};
+	}
+
+	/** Must be called with interrupts disabled. */
+	uint8_t planned_position_unlocked() const {
+		uint8_t pos = advance(position_, direction_, steps_remaining_);
+		for(uint8_t i = queue_head_; i != queue_tail_; ++i) {
+			const Segment& segment = queue_[i & queue_mask];
+			pos = advance(pos, segment.direction, segment.steps);
+		}
+		return pos;
+	}
+
+	/** Must be called with interrupts disabled. */
+	bool push(const Segment& segment) {
+		if(static_cast<uint8_t>(queue_tail_ - queue_head_) == QueueSize) {
+			return false;
+		}
+		if(segment.steps == 0u) {
+			return true;
+		}
+		if(steps_remaining_ == 0u) {
+			(void)start_segment(segment);
+			return true;
+		}
+		queue_[queue_tail_++ & queue_mask] = segment;
+		plan_run();
+		return true;
+	}
+
+	/**
+	 * Count the steps until the motor has to stop: the rest of the current move and the
+	 * queued moves that carry on in the same direction.  Must be called with interrupts
+	 * disabled.
+	 */
+	void plan_run() {
+		uint16_t steps = steps_remaining_;
+		for(uint8_t i = queue_head_; i != queue_tail_; ++i) {
+			const Segment& segment = queue_[i & queue_mask];
+			if(segment.direction != direction_) {
+				break;
+			}
+			steps += segment.steps;
+		}
+		run_steps_ = steps;
+	}
+
+	/**
+	 * Make 'segment' the current move.  Returns true if the motor starts from a
+	 * standstill (and the timer has been set up for the first step), or false if it
+	 * carries on at its current speed.  Must be called with interrupts disabled.
+	 */
+	bool start_segment(const Segment& segment) {
+		// Turning around starts the ramp over rather than reversing at full speed.
+		bool running = (TIMSK1 & _BV(OCIE1A)) and segment.direction == direction_;
+		direction_ = segment.direction;
+		steps_remaining_ = segment.steps;
+		cruise_interval_ = segment.interval;
+		plan_run();
+		if(segment.steps == 0u) {
+			TIMSK1 &= ~_BV(OCIE1A);
+			return true;
+		}
+		if(running) {
+			return false;
+		}
+		ramp_steps_ = 0u;
+		interval_ = first_interval_;
+		TCNT1 = 0u;
+		OCR1A = clamp_interval() - 1u;
+		TIFR1 = _BV(OCF1A);
+		TIMSK1 |= _BV(OCIE1A);
+		return true;
+	}
+
+	/** Advance the speed profile by one step and return the interval until the next one. */
+	uint16_t next_interval() {
+		if(run_steps_ <= ramp_steps_) {
+			// Just enough steps left to slow down: undo one step of the ramp.
+			if(ramp_steps_ != 0u) {
+				interval_ += (2u * interval_) / (4u * ramp_steps_ - 1u);
+				--ramp_steps_;
+			}
+		} else if(interval_ > cruise_interval_) {
+			++ramp_steps_;
+			interval_ -= (2u * interval_) / (4u * ramp_steps_ + 1u);
+			if(interval_ < cruise_interval_) {
+				interval_ = cruise_interval_;
+			}
+		} else if(interval_ < cruise_interval_ and ramp_steps_ != 0u) {
+			// The current move is slower than the previous one.
+			interval_ += (2u * interval_) / (4u * ramp_steps_ - 1u);
+			--ramp_steps_;
+			if(interval_ > cruise_interval_) {
+				interval_ = cruise_interval_;
+			}
+		}
+		return clamp_interval();
+	}
+
+	/** The current interval in whole ticks, never slower than 'start_interval'. */
+	uint16_t clamp_interval() const {
+		uint32_t ticks = interval_ >> 8u;
+		if(ticks > start_interval) {
+			return start_interval;
+		}
+		return static_cast<uint16_t>(ticks);
+	}
+
+	void forward_step() {
+		++position_;
+		position_ %= N;
+		++state_;
+		publish();
+	}
+
+	void backward_step() {
+		if(position_ == 0u) {
+			position_ = N;
+		}
+		--position_;
+		--state_;
+		publish();
+	}
+
+	/** Must be called with interrupts disabled. */
+	void remember() {
+		memory_.save(StepperState{position_, state_});
+	}
+
+	static constexpr uint8_t pin_mask = StaticPin<E1>::mask | StaticPin<E2>::mask
+		| StaticPin<M1>::mask | StaticPin<M2>::mask;
+
+	/** Apply the current state to the coils.  Must be called with interrupts disabled. */
+	void publish() const {
+		uint8_t bits = *(step_table<Sequence, E1, E2, M1, M2>.begin() + state());
+		volatile uint8_t& port = StaticPin<E1>::output_register();
+		port = (port & ~pin_mask) | bits;
 	}
 
 	uint8_t state() const {
-		return state_ % 4u;
+		return state_ & (sequence_length - 1u);
 	}
 
 	uint8_t state_ = 0u;
-	uint8_t position_ = 0u;
+	volatile uint8_t position_ = 0u;
+	volatile uint8_t steps_remaining_ = 0u;
+	volatile Direction direction_ = Direction::Forward;
+	// Speed profile, in 24.8 fixed point Timer1 ticks.
+	uint32_t interval_ = 0u;
+	uint32_t cruise_interval_ = 0u;
+	uint32_t first_interval_ = 0u;
+	uint32_t default_interval_ = 0u;
+	// Number of steps taken up the acceleration ramp.
+	uint16_t ramp_steps_ = 0u;
+	// Steps left before the motor has to stop.
+	uint16_t run_steps_ = 0u;
+	Segment queue_[QueueSize];
+	volatile uint8_t queue_head_ = 0u;
+	volatile uint8_t queue_tail_ = 0u;
+	Memory memory_;
 };
 
 } /* namespace ino */
@@ -245,8 +245,12 @@ constexpr Optional<Int> parse_decimal(StringView<> sv) {
 			return nullopt;
 		}
 		negate = true;
+		break;
+	default:
+		return nullopt;
 	}
 
+	bool digits = sv.front() >= '0' and sv.front() <= '9';
 	sv.remove_prefix(1);
 	for(char c: sv) {
 		if(c >= '0' and c <= '9') {
@@ -261,10 +265,16 @@ constexpr Optional<Int> parse_decimal(StringView<> sv) {
 				return nullopt;
 			}
 			value += digit;
+			digits = true;
 		} else {
-			break;
+			// Trailing garbage: the whole token must be a number.
+			return nullopt;
 		}
 	}
+	if(not digits) {
+		// A lone sign.
+		return nullopt;
+	}
 	if(negate) {
 		value = -value;
 	}
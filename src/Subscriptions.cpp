@@ -0,0 +1,82 @@
+#include "Subscriptions.h"
+#include "commands/checkengine.h"
+#include "commands/stepper_control.h"
+
+namespace ino {
+
+static Subscription subscriptions[max_subscriptions] = {};
+
+int8_t subscribe(TelemetrySource source, const CheckedPin* pin, uint16_t period_ms) {
+	if(period_ms == 0u) {
+		period_ms = 1u;
+	}
+	for(uint8_t id = 0u; id < max_subscriptions; ++id) {
+		if(subscriptions[id].period == 0u) {
+			subscriptions[id] = Subscription{
+				source,
+				pin ? static_cast<uint8_t>(pin->index()) : uint8_t(0u),
+				period_ms,
+				millis()
+			};
+			return static_cast<int8_t>(id);
+		}
+	}
+	return -1;
+}
+
+bool unsubscribe(uint8_t id) {
+	if(not find_subscription(id)) {
+		return false;
+	}
+	subscriptions[id].period = 0u;
+	return true;
+}
+
+void unsubscribe_all() {
+	for(Subscription& sub: subscriptions) {
+		sub.period = 0u;
+	}
+}
+
+const Subscription* find_subscription(uint8_t id) {
+	if(id >= max_subscriptions or subscriptions[id].period == 0u) {
+		return nullptr;
+	}
+	return &subscriptions[id];
+}
+
+static int16_t sample(const Subscription& sub) {
+	switch(sub.source) {
+	case TelemetrySource::AnalogRead:
+		return static_cast<int16_t>(all_pins[sub.pin].analog_read().first);
+	case TelemetrySource::DigitalRead:
+		return all_pins[sub.pin].digital_read() == LogicLevel::High ? 1 : 0;
+	case TelemetrySource::CheckengineStatus:
+		return checkengine_status() == LogicLevel::High ? 1 : 0;
+	case TelemetrySource::Window:
+		return window(Switch::Query);
+	case TelemetrySource::AnalogFiltered:
+		return static_cast<int16_t>(all_pins[sub.pin].analog_read(AnalogRead::Filtered).first);
+	}
+	return -1;
+}
+
+uint8_t sample_subscriptions(Span<TelemetrySample> samples) {
+	uint32_t now = millis();
+	uint8_t count = 0u;
+	for(uint8_t id = 0u; id < max_subscriptions and count < samples.size(); ++id) {
+		Subscription& sub = subscriptions[id];
+		if(sub.period == 0u or static_cast<int32_t>(now - sub.due) < 0) {
+			continue;
+		}
+		samples[count++] = TelemetrySample{id, sample(sub)};
+		sub.due += sub.period;
+		if(static_cast<int32_t>(now - sub.due) >= 0) {
+			// Fell behind by a whole period; skip ahead rather than burst.
+			sub.due = now + sub.period;
+		}
+	}
+	return count;
+}
+
+} /* namespace ino */
@@ -0,0 +1,60 @@
+#ifndef INO_SUBSCRIPTIONS_H
+#define INO_SUBSCRIPTIONS_H
+
+#include <Arduino.h>
+#include "Pins.h"
+#include "Span.h"
+
+namespace ino {
+
+/** The read commands that can be subscribed to. */
+enum class TelemetrySource: uint8_t {
+	AnalogRead,
+	DigitalRead,
+	CheckengineStatus,
+	Window,
+	// 'analogread <pin> filtered'.
+	AnalogFiltered
+};
+
+struct Subscription {
+	TelemetrySource source;
+	/** Index in 'all_pins' of the pin read by AnalogRead, DigitalRead and AnalogFiltered. */
+	uint8_t pin;
+	/** Sampling period in milliseconds; 0 marks a free slot. */
+	uint16_t period;
+	/** millis() at which the next sample is due. */
+	uint32_t due;
+};
+
+/** One value read for a subscription. */
+struct TelemetrySample {
+	uint8_t id;
+	int16_t value;
+};
+
+inline constexpr uint8_t max_subscriptions = 8u;
+
+/**
+ * Sample 'source' every 'period_ms' milliseconds.  Returns the subscription ID, or -1
+ * if all 'max_subscriptions' slots are taken.
+ */
+int8_t subscribe(TelemetrySource source, const CheckedPin* pin, uint16_t period_ms);
+
+/** Cancel a subscription.  Returns false if 'id' is not subscribed. */
+bool unsubscribe(uint8_t id);
+
+void unsubscribe_all();
+
+/** The subscription with the given ID, or nullptr if there is none. */
+const Subscription* find_subscription(uint8_t id);
+
+/**
+ * Read every subscription that is due into 'samples' and return how many there are.
+ * Call from the main loop; all samples of one call belong on one output line.
+ */
+uint8_t sample_subscriptions(Span<TelemetrySample> samples);
+
+} /* namespace ino */
+
+#endif /* INO_SUBSCRIPTIONS_H */
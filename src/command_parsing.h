@@ -7,6 +7,9 @@
 #include <cstddef>
 #include "ino_assert.h"
 #include "StringView.h"
+#include "Span.h"
+#include "BinaryCommand.h"
+#include <util/crc16.h>
 
 namespace ino {
 
@@ -57,34 +60,146 @@ int tokenize_line(ino::StringView<> (&buff)[N], ino::StringView<> line) {
 	return -1;
 }
 
-template <std::size_t N>
-[[nodiscard]]
-signed long read_line(HardwareSerial& ser, char (&buff)[N]) {
-	// Read a line from the serial object into the buffer.
-	char* buffpos = buff;
-	char* const endpos = buff + N;
-	while(buffpos < endpos) {
-		int read_val = ser.read();
-		// Keep trying to read data from serial.
-		while(read_val == -1) {
-			// Manual devirtualization.
-			read_val = ser.HardwareSerial::read();
+enum class ReadStatus {
+	// No complete line/frame is available yet; call poll() again later.
+	Incomplete,
+	// A complete line/frame has been read.
+	Complete,
+	// The line/frame did not fit in the buffer and was discarded.
+	Overflow,
+	// The frame's CRC did not match and the frame was discarded.
+	BadChecksum
+};
+
+/**
+ * Resumable, zero-copy line reader.  Each call to poll() only looks at the bytes that are
+ * already in the serial receive buffer, so the main loop never waits on the host.  Lines
+ * are not copied out of the receive buffer; line() (and any tokens made from it) points
+ * directly into it until release() is called.
+ *
+ * @note The longest line that can be read is one less than the receive buffer size.
+ */
+struct LineReader {
+
+	/**
+	 * Check for a complete line in the receive buffer.  Returns 'Complete' once a full line
+	 * has been received, and 'Overflow' once the end of a line that did not fit in the
+	 * receive buffer has been received.  Any line still held from a previous call is
+	 * released first.
+	 */
+	[[nodiscard]]
+	ReadStatus poll(HardwareSerial& ser) {
+		release(ser);
+		const char* data = nullptr;
+		int length = ser.peekLine(&data);
+		if(length == -2) {
+			// Ignore the rest of the line when it arrives.
+			overflow_ = true;
+			return ReadStatus::Incomplete;
+		} else if(length < 0) {
+			return ReadStatus::Incomplete;
 		}
-		char chr = static_cast<char>(read_val);
-		ASSERT(static_cast<char>(chr) != '\0');
-		// Encountered newline; all done.
-		if(static_cast<char>(chr) == '\n') {
-			// Write a null terminator and return.
-			*buffpos = '\0';
-			return buffpos - buff;
-		} else {
-			// Otherwise write the character and continue reading.
-			*buffpos++ = static_cast<char>(chr);
+		line_ = ino::StringView<>(data, static_cast<std::size_t>(length));
+		held_ = static_cast<std::size_t>(length) + 1u;
+		if(overflow_) {
+			overflow_ = false;
+			release(ser);
+			return ReadStatus::Overflow;
 		}
+		return ReadStatus::Complete;
 	}
-	// Too much data for the buffer.
-	return -1;
-}
+
+	/** The line found by the last successful poll().  Valid until release() is called. */
+	[[nodiscard]]
+	ino::StringView<> line() const {
+		return line_;
+	}
+
+	/** Drop the current line (and its newline) from the receive buffer. */
+	void release(HardwareSerial& ser) {
+		if(held_ != 0u) {
+			ser.discard(held_);
+			held_ = 0u;
+			line_ = {};
+		}
+	}
+
+private:
+	ino::StringView<> line_;
+	std::size_t held_ = 0u;
+	bool overflow_ = false;
+};
+
+/**
+ * Resumable reader for binary protocol frames (see BinaryCommand.h).  Like LineReader,
+ * poll() only consumes bytes that are already available.  Bytes received outside of a
+ * frame are discarded.
+ */
+template <std::size_t N>
+struct FrameReader {
+
+	/**
+	 * Consume the available bytes.  Returns 'Complete' once a full frame with a valid CRC
+	 * has been read; the bytes between its length byte and its CRC are then available
+	 * through frame() until the next call to poll().
+	 */
+	[[nodiscard]]
+	ReadStatus poll(HardwareSerial& ser) {
+		for(int read_val = ser.HardwareSerial::read(); read_val != -1; read_val = ser.HardwareSerial::read()) {
+			auto byte = static_cast<uint8_t>(read_val);
+			switch(state_) {
+			case State::Start:
+				if(byte == frame_start) {
+					state_ = State::Length;
+				}
+				break;
+			case State::Length:
+				length_ = byte;
+				size_ = 0u;
+				crc_ = _crc8_ccitt_update(0u, byte);
+				state_ = (length_ == 0u) ? State::Crc : State::Body;
+				break;
+			case State::Body:
+				crc_ = _crc8_ccitt_update(crc_, byte);
+				if(size_ < N) {
+					buff_[size_] = byte;
+				}
+				if(++size_ == length_) {
+					state_ = State::Crc;
+				}
+				break;
+			case State::Crc:
+				state_ = State::Start;
+				if(length_ > N) {
+					return ReadStatus::Overflow;
+				} else if(crc_ != byte) {
+					return ReadStatus::BadChecksum;
+				}
+				return ReadStatus::Complete;
+			}
+		}
+		return ReadStatus::Incomplete;
+	}
+
+	[[nodiscard]]
+	ino::Span<const uint8_t> frame() const {
+		return {buff_, length_};
+	}
+
+private:
+	enum class State: uint8_t {
+		Start,
+		Length,
+		Body,
+		Crc
+	};
+
+	uint8_t buff_[N] = {0u};
+	State state_ = State::Start;
+	uint8_t length_ = 0u;
+	uint8_t size_ = 0u;
+	uint8_t crc_ = 0u;
+};
 
 } /* namespace ino */
 
@@ -0,0 +1,68 @@
+#include "commands/adcconfig.h"
+#include "Adc.h"
+
+namespace ino {
+
+static int print_config() {
+	AdcConfig config = adc_config();
+	Serial.print(F("PRESCALER "));
+	Serial.print(config.prescaler);
+	Serial.print(F(" BITS "));
+	Serial.print(config.bits);
+	switch(config.reference) {
+	case AdcReference::External:
+		Serial.println(F(" REF EXTERNAL"));
+		break;
+	case AdcReference::AVcc:
+		Serial.println(F(" REF AVCC"));
+		break;
+	case AdcReference::Internal1V1:
+		Serial.println(F(" REF INTERNAL"));
+		break;
+	}
+	return 0;
+}
+
+int cmd_adcconfig(Span<StringView<>> argv) {
+	if(argv.size() == 1u) {
+		return print_config();
+	} else if(argv.size() % 2u != 1u) {
+		return command_error(F("Command 'adcconfig' expects pairs of settings and values."));
+	}
+	AdcConfig config = adc_config();
+	for(std::size_t i = 1u; i < argv.size(); i += 2u) {
+		StringView<> setting = argv[i];
+		StringView<> value = argv[i + 1u];
+		if(setting == "prescaler") {
+			Optional<uint8_t> prescaler = parse_decimal<uint8_t>(value);
+			if(not prescaler) {
+				return command_error(F("Cannot parse '"), value, F("' as a prescaler."));
+			}
+			config.prescaler = *prescaler;
+		} else if(setting == "bits") {
+			Optional<uint8_t> bits = parse_decimal<uint8_t>(value);
+			if(not bits) {
+				return command_error(F("Cannot parse '"), value, F("' as a resolution."));
+			}
+			config.bits = *bits;
+		} else if(setting == "ref") {
+			if(value == "AVCC" or value == "avcc") {
+				config.reference = AdcReference::AVcc;
+			} else if(value == "INTERNAL" or value == "internal") {
+				config.reference = AdcReference::Internal1V1;
+			} else if(value == "EXTERNAL" or value == "external") {
+				config.reference = AdcReference::External;
+			} else {
+				return command_error(F("Invalid reference '"), value, F("'.  Valid values are 'AVCC', 'INTERNAL', or 'EXTERNAL'."));
+			}
+		} else {
+			return command_error(F("Invalid setting '"), setting, F("'.  Valid settings are 'prescaler', 'bits', or 'ref'."));
+		}
+	}
+	if(not adc_configure(config)) {
+		return command_error(F("The prescaler must be a power of two from 2 to 128, and bits must be 8 or 10."));
+	}
+	return print_config();
+}
+
+} /* namespace ino */
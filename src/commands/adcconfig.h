@@ -0,0 +1,20 @@
+#ifndef INO_ADCCONFIG_H
+#define INO_ADCCONFIG_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_adcconfig(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_adcconfig> = CommandTraits{
+	"adcconfig",
+	"adcconfig [prescaler <2-128>] [bits <8/10>] [ref <AVCC/INTERNAL/EXTERNAL>]",
+	"Show or change the ADC clock prescaler, result resolution and voltage reference."
+};
+
+} /* namespace ino */
+
+#endif /* INO_ADCCONFIG_H */
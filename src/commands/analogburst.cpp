@@ -0,0 +1,90 @@
+#include "commands/analogburst.h"
+#include "Adc.h"
+
+namespace ino {
+
+static uint32_t isqrt64(uint64_t value) {
+	uint64_t root = 0u;
+	uint64_t bit = 1ull << 62u;
+	while(bit > value) {
+		bit >>= 2u;
+	}
+	while(bit != 0u) {
+		if(value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1u) + bit;
+		} else {
+			root >>= 1u;
+		}
+		bit >>= 2u;
+	}
+	return static_cast<uint32_t>(root);
+}
+
+/** Print hundredths as '<units>.<hundredths>'. */
+static void print_centi(uint32_t value) {
+	Serial.print(value / 100u);
+	Serial.print('.');
+	uint8_t fraction = value % 100u;
+	if(fraction < 10u) {
+		Serial.print('0');
+	}
+	Serial.print(fraction);
+}
+
+int cmd_analogburst(Span<StringView<>> argv) {
+	const auto* pin = pincommand_check(argv, 3);
+	if(not pin) {
+		return -1;
+	}
+	Optional<uint16_t> count = parse_decimal<uint16_t>(argv[2]);
+	if(not count or *count == 0u or *count > analogburst_max_count) {
+		return command_error(F("The count '"), argv[2], F("' must be in the range [1, "), analogburst_max_count, "].");
+	}
+	bool scanning = adc_scanning();
+	uint16_t min = 0xFFFFu;
+	uint16_t max = 0u;
+	uint32_t sum = 0u;
+	uint32_t sum_squares = 0u;
+	for(uint16_t i = 0u; i < *count; ++i) {
+		// Cached scan results would repeat the same value, so every sample is converted.
+		auto [value, status] = pin->analog_read(AnalogRead::Fresh);
+		if(status == PinStatus::BadPinKind) {
+			return command_error("Pin ", argv[1], F(" is not an analog pin."));
+		} else if(status == PinStatus::BadPinMode) {
+			return command_error("Pin ", argv[1], F(" is not in INPUT or INPUT_PULLUP mode."));
+		} else if(status == PinStatus::AdcBusy and adc_released()) {
+			return command_error(F("The ADC is in use by the comparator."));
+		} else if(status == PinStatus::AdcBusy) {
+			return command_error(F("The ADC is streaming."));
+		} else if(status != PinStatus::Good) {
+			return command_error(F("Unable to read from pin "), argv[1], ".");
+		}
+		uint16_t sample = static_cast<uint16_t>(value);
+		if(sample < min) {
+			min = sample;
+		}
+		if(sample > max) {
+			max = sample;
+		}
+		sum += sample;
+		sum_squares += uint32_t(sample) * sample;
+	}
+	if(scanning) {
+		adc_start_scan();
+	}
+	uint32_t mean = (sum * 100u + *count / 2u) / *count;
+	uint32_t rms = isqrt64(uint64_t(sum_squares) * 10000u / *count);
+	Serial.print(F("MIN "));
+	Serial.print(min);
+	Serial.print(F(" MAX "));
+	Serial.print(max);
+	Serial.print(F(" MEAN "));
+	print_centi(mean);
+	Serial.print(F(" RMS "));
+	print_centi(rms);
+	Serial.println();
+	return 0;
+}
+
+} /* namespace ino */
@@ -0,0 +1,24 @@
+#ifndef INO_ANALOGBURST_H
+#define INO_ANALOGBURST_H
+
+#include "Command.h"
+
+namespace ino {
+
+/** Largest burst; with 10-bit samples the sum of squares still fits in 32 bits. */
+inline constexpr uint16_t analogburst_max_count = 4096u;
+
+int cmd_analogburst(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_analogburst> = CommandTraits{
+	"analogburst",
+	"analogburst <pin> <count>",
+	"Convert an analog pin <count> times back to back (at most 4096) and show "
+	"'MIN <min> MAX <max> MEAN <mean> RMS <rms>', with the mean and RMS to two decimals."
+};
+
+} /* namespace ino */
+
+#endif /* INO_ANALOGBURST_H */
@@ -0,0 +1,58 @@
+#include "commands/analogfilter.h"
+#include "Adc.h"
+
+namespace ino {
+
+static int print_filter(uint8_t channel) {
+	AnalogFilterConfig filter = adc_filter(channel);
+	Serial.print(F("MEDIAN "));
+	Serial.print(filter.median);
+	Serial.print(F(" EMA "));
+	Serial.print(filter.ema_shift);
+	Serial.print(F(" DECIMATE "));
+	Serial.println(filter.decimation);
+	return 0;
+}
+
+int cmd_analogfilter(Span<StringView<>> argv) {
+	const auto* pin = pincommand_check(argv, 2, 8);
+	if(not pin) {
+		return -1;
+	}
+	if(pin->kind() != PinKind::Analog) {
+		return command_error("Pin ", argv[1], F(" is not an analog pin."));
+	}
+	uint8_t channel = static_cast<uint8_t>(pin->number() - A0);
+	if(argv.size() == 2u) {
+		return print_filter(channel);
+	}
+	AnalogFilterConfig filter = adc_filter(channel);
+	if(argv.size() == 3u and (argv[2] == "off" or argv[2] == "OFF")) {
+		filter = analog_filter_off;
+	} else if(argv.size() % 2u != 0u) {
+		return command_error(F("Command 'analogfilter' expects pairs of settings and values."));
+	} else {
+		for(std::size_t i = 2u; i < argv.size(); i += 2u) {
+			StringView<> setting = argv[i];
+			Optional<uint8_t> value = parse_decimal<uint8_t>(argv[i + 1u]);
+			if(not value) {
+				return command_error(F("Cannot parse '"), argv[i + 1u], F("' as a decimal integer."));
+			}
+			if(setting == "median") {
+				filter.median = *value;
+			} else if(setting == "ema") {
+				filter.ema_shift = *value;
+			} else if(setting == "decimate") {
+				filter.decimation = *value;
+			} else {
+				return command_error(F("Invalid setting '"), setting, F("'.  Valid settings are 'median', 'ema', or 'decimate'."));
+			}
+		}
+	}
+	if(not adc_set_filter(channel, filter)) {
+		return command_error(F("The median must be 1, 3 or 5, ema at most "), analog_filter_max_ema_shift, F(", and decimate at least 1."));
+	}
+	return print_filter(channel);
+}
+
+} /* namespace ino */
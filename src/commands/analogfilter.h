@@ -0,0 +1,22 @@
+#ifndef INO_ANALOGFILTER_H
+#define INO_ANALOGFILTER_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_analogfilter(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_analogfilter> = CommandTraits{
+	"analogfilter",
+	"analogfilter <pin> [off | [median <1/3/5>] [ema <0-6>] [decimate <1-255>]]",
+	"Show or change the filter an analog pin's conversions go through: a median, an average "
+	"weighting each sample 1/2^ema, then keeping one output in 'decimate'.  Filtered values "
+	"are read with 'analogread <pin> filtered', subscriptions and analogstream."
+};
+
+} /* namespace ino */
+
+#endif /* INO_ANALOGFILTER_H */
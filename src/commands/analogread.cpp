@@ -1,19 +1,102 @@
 #include "commands/analogread.h"
+#include "Adc.h"
+#include "Calibration.h"
+
+namespace ino {
+
+static void print_units(int16_t value, CalibrationUnit unit) {
+	uint8_t decimals = 0u;
+	const __FlashStringHelper* suffix = nullptr;
+	switch(unit) {
+	case CalibrationUnit::Volts:
+		decimals = 3u;
+		suffix = F(" V");
+		break;
+	}
+	if(value < 0) {
+		Serial.print('-');
+	}
+	uint16_t magnitude = value < 0 ? uint16_t(-int32_t(value)) : uint16_t(value);
+	uint16_t scale = 1u;
+	for(uint8_t i = 0u; i < decimals; ++i) {
+		scale *= 10u;
+	}
+	Serial.print(magnitude / scale);
+	if(decimals != 0u) {
+		Serial.print('.');
+		uint16_t fraction = magnitude % scale;
+		for(scale /= 10u; scale > 1u and fraction < scale; scale /= 10u) {
+			Serial.print('0');
+		}
+		Serial.print(fraction);
+	}
+	Serial.println(suffix);
+}
+
+} /* namespace ino */
 
 int ino::cmd_analogread(Span<StringView<>> argv) {
-	const auto* pin = pincommand_check(argv, 2);
+	const auto* pin = pincommand_check(argv, 2, 5);
 	if(not pin) {
 		return -1;
 	}
-	auto [value, status]= pin->analog_read();
+	AnalogRead how = AnalogRead::Latest;
+	uint8_t bits = 0u;
+	bool units = false;
+	for(std::size_t i = 2u; i < argv.size(); ++i) {
+		if(argv[i] == "quiet" or argv[i] == "QUIET") {
+			if(how == AnalogRead::Filtered) {
+				return command_error(F("The options 'quiet' and 'filtered' to analogread cannot be combined."));
+			}
+			how = AnalogRead::Asleep;
+			continue;
+		} else if(argv[i] == "filtered" or argv[i] == "FILTERED") {
+			if(how == AnalogRead::Asleep) {
+				return command_error(F("The options 'quiet' and 'filtered' to analogread cannot be combined."));
+			}
+			how = AnalogRead::Filtered;
+			continue;
+		} else if(argv[i] == "units" or argv[i] == "UNITS") {
+			units = true;
+			continue;
+		}
+		Optional<uint8_t> parsed = parse_decimal<uint8_t>(argv[i]);
+		if(not parsed or *parsed == 0u or bits != 0u) {
+			return command_error(F("Invalid argument '"), argv[i], F("' to analogread.  Expected a resolution, 'quiet', 'filtered' or 'units'."));
+		}
+		bits = *parsed;
+	}
+	if(units and adc_config().reference != AdcReference::AVcc) {
+		return command_error(F("The calibration tables are for the AVCC reference."));
+	}
+	if(how == AnalogRead::Asleep) {
+		// The UART stops while the CPU sleeps.
+		Serial.flush();
+	}
+	auto [value, status]= pin->analog_read(how, bits);
 	if(status == PinStatus::BadPinKind) {
 		return command_error("Pin ", argv[1], F(" is not an analog pin."));
 	} else if(status == PinStatus::BadPinMode) {
 		return command_error("Pin ", argv[1], F(" is not in INPUT or INPUT_PULLUP mode."));
+	} else if(status == PinStatus::AdcBusy and adc_released()) {
+		return command_error(F("The ADC is in use by the comparator."));
+	} else if(status == PinStatus::AdcBusy and how == AnalogRead::Filtered) {
+		return command_error(F("Pin "), argv[1], F(" is not being scanned or streamed, so it has no filtered value."));
+	} else if(status == PinStatus::AdcBusy) {
+		return command_error(F("The ADC is streaming another pin."));
+	} else if(status == PinStatus::BadResolution and how == AnalogRead::Filtered) {
+		return command_error(F("Filtered values come in the configured resolution only."));
+	} else if(status == PinStatus::BadResolution) {
+		uint8_t base_bits = adc_config().bits;
+		return command_error(F("The resolution must be in the range ["), base_bits, ", ", base_bits + adc_max_extra_bits, "].");
 	} else if(status != PinStatus::Good) {
 		return command_error(F("Unable to read from pin "), argv[1], ".");
 	}
+	if(units) {
+		uint8_t channel = static_cast<uint8_t>(pin->number() - A0);
+		print_units(calibrate(channel, value, bits == 0u ? adc_config().bits : bits), calibration_unit(channel));
+		return 0;
+	}
 	Serial.println(value);
 	return 0;
 }
-
@@ -13,8 +13,12 @@ template <>
 [[gnu::progmem]]
 inline constexpr auto command_traits<cmd_analogread> = CommandTraits{
 	"analogread",
-	"analogread <pin>",
-	"Show the analog voltage reading in the range [0, 1024) for the pin."
+	"analogread <pin> [bits] [quiet | filtered] [units]",
+	"Show the analog voltage reading for the pin, in the range [0, 1024) (or [0, 256) with 8-bit adcconfig). "
+	"With 11 or 12 bits (9 or 10 at 8-bit adcconfig), oversample for a finer reading; with 'quiet', convert "
+	"in the ADC noise reduction sleep mode, which pauses millis(), the stepper and the serial port; with "
+	"'filtered', show the output of the pin's analogfilter; with 'units', convert the reading with the "
+	"pin's calibration table, e.g. '4.995 V'."
 };
 
 } /* namespace ino */
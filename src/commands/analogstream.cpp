@@ -0,0 +1,71 @@
+#include "commands/analogstream.h"
+#include "Adc.h"
+
+namespace ino {
+
+static int dump_stream() {
+	uint8_t count = adc_stream_available();
+	bool eight_bit = adc_config().bits == 8u;
+	Serial.print(F("STREAM "));
+	Serial.print(count);
+	Serial.print(' ');
+	Serial.print(adc_take_overruns());
+	Serial.print(' ');
+	Serial.println(adc_config().bits);
+	uint16_t samples[16];
+	while(count != 0u) {
+		uint8_t taken = adc_take_samples(Span(samples, count < 16u ? count : uint8_t(16u)));
+		if(eight_bit) {
+			uint8_t bytes[16];
+			for(uint8_t i = 0u; i < taken; ++i) {
+				bytes[i] = static_cast<uint8_t>(samples[i]);
+			}
+			Serial.write(bytes, taken);
+		} else {
+			// AVR is little-endian, so the samples go out as they are in memory.
+			Serial.write(reinterpret_cast<const uint8_t*>(samples), taken * sizeof(samples[0]));
+		}
+		count -= taken;
+	}
+	Serial.println();
+	return 0;
+}
+
+int cmd_analogstream(Span<StringView<>> argv) {
+	switch(argv.size()) {
+	default:
+		return command_error(F("Command 'analogstream' takes at most 2 arguments."));
+	case 1:
+		return dump_stream();
+	case 2:
+		if(argv[1] == "stop") {
+			adc_stop_stream();
+			return 0;
+		}
+		break;
+	case 3:
+		break;
+	}
+	const auto* pin = pin_from_name(argv[1]);
+	if(not pin) {
+		return command_error(F("Invalid pin name '"), argv[1], F("'."));
+	} else if(pin->kind() != PinKind::Analog) {
+		return command_error(F("Pin "), argv[1], F(" is not an analog pin."));
+	} else if(pin->mode() == PinMode::Output) {
+		return command_error(F("Pin "), argv[1], F(" is not in INPUT or INPUT_PULLUP mode."));
+	}
+	uint8_t divider = 1u;
+	if(argv.size() == 3u) {
+		Optional<uint8_t> value = parse_decimal<uint8_t>(argv[2]);
+		if(not value or *value == 0u) {
+			return command_error(F("Invalid divider '"), argv[2], F("' (must be in the range [1, 255])."));
+		}
+		divider = *value;
+	}
+	if(not adc_start_stream(static_cast<uint8_t>(pin->number() - A0), divider)) {
+		return command_error(F("The ADC is in use by the comparator."));
+	}
+	return 0;
+}
+
+} /* namespace ino */
@@ -0,0 +1,22 @@
+#ifndef INO_ANALOGSTREAM_H
+#define INO_ANALOGSTREAM_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_analogstream(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_analogstream> = CommandTraits{
+	"analogstream",
+	"analogstream [<pin> [divider] | stop]",
+	"Sample an analog pin continuously (keeping every divider'th sample), stop, or dump the "
+	"buffered samples: a 'STREAM <count> <dropped> <bits>' line, then <count> samples (one "
+	"byte each with 8 bits, else little-endian 16-bit), then a newline."
+};
+
+} /* namespace ino */
+
+#endif /* INO_ANALOGSTREAM_H */
@@ -9,7 +9,7 @@ int ino::cmd_analogwrite(Span<StringView<>> argv) {
 	if(not value) {
 		return command_error("Cannot parse '", argv[2], F("' as a decimal integer in analogwrite."));
 	}
-	PinStatus status = pin->analog_write(value);
+	PinStatus status = pin->analog_write(*value);
 	switch(status) {
 	default:
 		return command_error("Unable to write to pin ", argv[1], ".");
@@ -0,0 +1,10 @@
+#include "commands/binary.h"
+#include "BinaryCommand.h"
+
+int ino::cmd_binary(Span<StringView<>> argv) {
+	if(argv.size() != 1) {
+		return command_error(F("Command 'binary' takes no arguments."));
+	}
+	set_active_protocol(Protocol::Binary);
+	return command_success(F("BINARY"));
+}
@@ -0,0 +1,20 @@
+#ifndef INO_BINARY_H
+#define INO_BINARY_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_binary(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_binary> = CommandTraits{
+	"binary",
+	"binary",
+	"Switch the serial link to the framed binary protocol (command 0x00 switches back)."
+};
+
+} /* namespace ino */
+
+#endif /* INO_BINARY_H */
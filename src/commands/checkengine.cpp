@@ -1,6 +1,7 @@
 #include "commands/checkengine.h"
 #include "Command.h"
 #include "Pins.h"
+#include "PinEvents.h"
 
 namespace ino {
 
@@ -8,23 +9,46 @@ static constexpr int8_t switch_pin = 2;
 static constexpr int8_t led_pin = 10;
 
 void checkengine_interrupt() {
+	capture_pin_edge(pin<switch_pin>);
+}
+
+void checkengine_begin() {
+	pin<switch_pin>.set_mode(PinMode::Input);
+	pin<led_pin>.set_mode(PinMode::Output);
+	track_pin_events(pin<switch_pin>);
+	(void)pin<led_pin>.digital_write(pin<switch_pin>.digital_read());
+}
+
+void checkengine_pin_event(const PinEvent& event) {
+	if(event.pin == pin<switch_pin>.index()) {
+		(void)pin<led_pin>.digital_write(event.level);
+	}
+}
+
+LogicLevel checkengine_status() {
 	pin<switch_pin>.set_mode(PinMode::Input);
+	return pin<switch_pin>.digital_read();
+}
+
+LogicLevel checkengine_light(Switch request) {
 	pin<led_pin>.set_mode(PinMode::Output);
- 	switch(digitalRead(switch_pin)) {
-	case LOW:
-		pin<led_pin>.digital_write(LogicLevel::Low);
+	switch(request) {
+	case Switch::On:
+		(void)pin<led_pin>.digital_write(LogicLevel::High);
 		break;
-	case HIGH:
-		pin<led_pin>.digital_write(LogicLevel::High);
+	case Switch::Off:
+		(void)pin<led_pin>.digital_write(LogicLevel::Low);
+		break;
+	case Switch::Query:
 		break;
 	}
+	return pin<led_pin>.digital_read();
 }
 
 int cmd_checkengine_status(Span<StringView<>> argv) {
-	pin<switch_pin>.set_mode(PinMode::Input);
 	if(argv.size() != 1) {
 		return command_error(F("Command 'checkengine_status' takes no arguments."));
-	} else if(digitalRead(switch_pin) == HIGH) {
+	} else if(checkengine_status() == LogicLevel::High) {
 		return command_success(1);
 	} else {
 		return command_success(0);
@@ -32,17 +56,15 @@ int cmd_checkengine_status(Span<StringView<>> argv) {
 }
 
 int cmd_checkengine_light(Span<StringView<>> argv) {
-	pin<led_pin>.set_mode(PinMode::Output);
+	Switch request = Switch::Query;
 	switch(argv.size()) {
 	default:
 		return command_error(F("Command 'checkengine_light' takes at most 1 argument."));
 	case 2:
 		if(argv[1] == "ON" or argv[1] == "on" or argv[1] == "1") {
-			(void)pin<led_pin>.digital_write(LogicLevel::High);
-			digitalWrite(led_pin, HIGH);
+			request = Switch::On;
 		} else if(argv[1] == "OFF" or argv[1] == "off" or argv[1] == "0") {
-			(void)pin<led_pin>.digital_write(LogicLevel::Low);
-			digitalWrite(led_pin, LOW);
+			request = Switch::Off;
 		} else {
 			return command_error(F("Expected one of 'on', 'ON', '1', 'off', 'OFF', or '0'."));
 		}
@@ -51,7 +73,7 @@ int cmd_checkengine_light(Span<StringView<>> argv) {
 		(void)0;
 	}
 	// Echo the current status of the led.
-	if(digitalRead(led_pin) == HIGH) {
+	if(checkengine_light(request) == LogicLevel::High) {
 		return command_success(1);
 	} else {
 		return command_success(0);
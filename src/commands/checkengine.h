@@ -5,12 +5,27 @@
 
 namespace ino {
 
+struct PinEvent;
+
+/** INT0 handler: records the switch edge for poll_pin_event(). */
 void checkengine_interrupt();
 
+/** Set up the switch and light pins and mirror the switch on the light. */
+void checkengine_begin();
+
+/** Mirror a settled change of the switch on the light.  Call from the main loop. */
+void checkengine_pin_event(const PinEvent& event);
+
 int cmd_checkengine_status(Span<StringView<>> argv);
 
 int cmd_checkengine_light(Span<StringView<>> argv);
 
+/** Read the check engine switch. */
+LogicLevel checkengine_status();
+
+/** Switch the check engine light on or off (or leave it alone) and return its current state. */
+LogicLevel checkengine_light(Switch request);
+
 template <>
 [[gnu::progmem]]
 inline constexpr auto command_traits<cmd_checkengine_status> = ino::CommandTraits{
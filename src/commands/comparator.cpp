@@ -0,0 +1,74 @@
+#include "commands/comparator.h"
+#include "AnalogComparator.h"
+
+namespace ino {
+
+static int print_comparator() {
+	if(not comparator_running()) {
+		Serial.println(F("COMPARATOR OFF"));
+		return 0;
+	}
+	Serial.print(F("COMPARATOR "));
+	Serial.print(comparator_pin().name());
+	switch(comparator_edge()) {
+	case ComparatorEdge::Both:
+		Serial.print(F(" BOTH"));
+		break;
+	case ComparatorEdge::Rising:
+		Serial.print(F(" RISING"));
+		break;
+	case ComparatorEdge::Falling:
+		Serial.print(F(" FALLING"));
+		break;
+	}
+	Serial.print(comparator_level() == LogicLevel::High ? F(" ABOVE") : F(" BELOW"));
+	Serial.print(F(" DROPPED "));
+	Serial.println(take_dropped_comparator_events());
+	return 0;
+}
+
+int cmd_comparator(Span<StringView<>> argv) {
+	switch(argv.size()) {
+	default:
+		return command_error(F("Command 'comparator' takes at most 2 arguments."));
+	case 1:
+		return print_comparator();
+	case 2:
+		if(argv[1] == "stop") {
+			comparator_stop();
+			return 0;
+		}
+		break;
+	case 3:
+		break;
+	}
+	const auto* pin = pin_from_name(argv[1]);
+	if(not pin) {
+		return command_error(F("Invalid pin name '"), argv[1], F("'."));
+	} else if(pin->mode() == PinMode::Output) {
+		return command_error(F("Pin "), argv[1], F(" is not in INPUT or INPUT_PULLUP mode."));
+	}
+	ComparatorEdge edge = ComparatorEdge::Both;
+	if(argv.size() == 3u) {
+		if(argv[2] == "rising") {
+			edge = ComparatorEdge::Rising;
+		} else if(argv[2] == "falling") {
+			edge = ComparatorEdge::Falling;
+		} else if(argv[2] != "both") {
+			return command_error(F("Invalid edge '"), argv[2], F("'.  Valid edges are 'rising', 'falling', or 'both'."));
+		}
+	}
+	switch(comparator_start(*pin, edge)) {
+	case PinStatus::Good:
+		break;
+	case PinStatus::BadPinKind:
+		return command_error(F("Pin "), argv[1], F(" is not an analog pin."));
+	case PinStatus::AdcBusy:
+		return command_error(F("The ADC is streaming; stop the stream first."));
+	default:
+		return command_error(F("Unable to watch pin "), argv[1], ".");
+	}
+	return 0;
+}
+
+} /* namespace ino */
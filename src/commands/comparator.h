@@ -0,0 +1,21 @@
+#ifndef INO_COMPARATOR_H
+#define INO_COMPARATOR_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_comparator(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_comparator> = CommandTraits{
+	"comparator",
+	"comparator [<pin> [rising | falling | both] | stop]",
+	"Report the analog pin crossing 1.1V as '!CMP <pin> <level> <micros>' lines, stop, or show "
+	"'COMPARATOR <pin> <edge> ABOVE|BELOW DROPPED <n>'.  Analog reads fail while it runs."
+};
+
+} /* namespace ino */
+
+#endif /* INO_COMPARATOR_H */
@@ -0,0 +1,25 @@
+#include "commands/events.h"
+#include "PinEvents.h"
+
+int ino::cmd_events(Span<StringView<>> argv) {
+	if(argv.size() != 1) {
+		return command_error(F("Command 'events' takes no arguments."));
+	}
+	if(uint8_t dropped = take_dropped_pin_events(); dropped != 0u) {
+		Serial.print(F("DROPPED "));
+		Serial.println(dropped);
+	}
+	if(uint8_t missed = take_missed_pin_edges(); missed != 0u) {
+		Serial.print(F("MISSED "));
+		Serial.println(missed);
+	}
+	PinEvent event;
+	while(next_logged_pin_event(event)) {
+		Serial.print(event.time);
+		Serial.print(' ');
+		Serial.print(all_pins[event.pin].name());
+		Serial.print(' ');
+		Serial.println(event.level == LogicLevel::High ? 1 : 0);
+	}
+	return 0;
+}
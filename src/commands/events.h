@@ -0,0 +1,22 @@
+#ifndef INO_EVENTS_H
+#define INO_EVENTS_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_events(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_events> = CommandTraits{
+	"events",
+	"events",
+	"Show and clear the debounced input changes as '<millis> <pin> <level>' lines, after "
+	"'DROPPED <n>' for changes pushed out of the log and 'MISSED <n>' for raw edges that "
+	"did not fit the queue."
+};
+
+} /* namespace ino */
+
+#endif /* INO_EVENTS_H */
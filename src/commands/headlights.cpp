@@ -1,16 +1,32 @@
 #include "commands/headlights.h"
 
+static constexpr int8_t headlights_pin = 9;
+
+ino::LogicLevel ino::headlights(Switch request) {
+	pin<headlights_pin>.set_mode(PinMode::Output);
+	switch(request) {
+	case Switch::On:
+		(void)pin<headlights_pin>.digital_write(LogicLevel::High);
+		break;
+	case Switch::Off:
+		(void)pin<headlights_pin>.digital_write(LogicLevel::Low);
+		break;
+	case Switch::Query:
+		break;
+	}
+	return pin<headlights_pin>.digital_read();
+}
+
 int ino::cmd_headlights(Span<StringView<>> argv) {
-	constexpr int8_t num = 9;
-	pin<num>.set_mode(PinMode::Output);
+	Switch request = Switch::Query;
 	switch(argv.size()) {
 	default:
 		return command_error(F("Command 'headlights' takes at most 1 argument."));
 	case 2:
 		if(argv[1] == "ON" or argv[1] == "on" or argv[1] == "1") {
-			(void)pin<num>.digital_write(LogicLevel::High);
+			request = Switch::On;
 		} else if(argv[1] == "OFF" or argv[1] == "off" or argv[1] == "0") {
-			(void)pin<num>.digital_write(LogicLevel::Low);
+			request = Switch::Off;
 		} else {
 			return command_error(F("Expected one of 'on', 'ON', 'off', or 'OFF'."));
 		}
@@ -19,7 +35,7 @@ int ino::cmd_headlights(Span<StringView<>> argv) {
 		(void)0;
 	}
 	// Echo the current status of the pin.
-	if(digitalRead(9) == HIGH) {
+	if(headlights(request) == LogicLevel::High) {
 		Serial.println(F("ON"));
 	} else {
 		Serial.println(F("OFF"));
@@ -27,4 +43,3 @@ int ino::cmd_headlights(Span<StringView<>> argv) {
 	return 0;
 
 }
-
@@ -7,6 +7,9 @@ namespace ino {
 
 int cmd_headlights(Span<StringView<>> argv);
 
+/** Switch the headlights on or off (or leave them alone) and return their current state. */
+LogicLevel headlights(Switch request);
+
 template <>
 [[gnu::progmem]]
 inline constexpr auto command_traits<cmd_headlights> = CommandTraits{
@@ -0,0 +1,61 @@
+#include "commands/portio.h"
+
+namespace ino {
+
+static bool parse_logic_level(StringView<> str, LogicLevel& level) {
+	if(str == "low" or str == "LOW" or str == "0") {
+		level = LogicLevel::Low;
+	} else if(str == "high"  or str == "HIGH" or str == "1") {
+		level = LogicLevel::High;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+int cmd_portwrite(Span<StringView<>> argv) {
+	if(argv.size() < 3u or argv.size() % 2u != 1u) {
+		return command_error(F("Command 'portwrite' expects pairs of pins and levels."));
+	}
+	PinSet pins;
+	for(std::size_t i = 1u; i < argv.size(); i += 2u) {
+		const auto* pin = pin_from_name(argv[i]);
+		if(not pin) {
+			return command_error(F("Invalid pin name '"), argv[i], F("'."));
+		} else if(pin->mode() != PinMode::Output) {
+			return command_error(F("Pin "), argv[i], F(" is not currently in OUTPUT mode."));
+		}
+		LogicLevel level = LogicLevel::Low;
+		if(not parse_logic_level(argv[i + 1u], level)) {
+			return command_error(F("Invalid logic level '"), argv[i + 1u], F("'."));
+		}
+		pins.add(*pin, level);
+	}
+	pins.write();
+	return 0;
+}
+
+int cmd_portread(Span<StringView<>> argv) {
+	if(argv.size() < 2u) {
+		return command_error(F("Command 'portread' expects at least 1 argument."));
+	}
+	PinSet pins;
+	for(std::size_t i = 1u; i < argv.size(); ++i) {
+		const auto* pin = pin_from_name(argv[i]);
+		if(not pin) {
+			return command_error(F("Invalid pin name '"), argv[i], F("'."));
+		}
+		pins.add(*pin);
+	}
+	PinSet sample = pins.read();
+	for(std::size_t i = 1u; i < argv.size(); ++i) {
+		if(i > 1u) {
+			Serial.print(' ');
+		}
+		Serial.print(sample.level(*pin_from_name(argv[i])) == LogicLevel::High ? '1' : '0');
+	}
+	Serial.println();
+	return 0;
+}
+
+} /* namespace ino */
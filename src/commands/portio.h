@@ -0,0 +1,30 @@
+#ifndef INO_PORTIO_H
+#define INO_PORTIO_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_portwrite(Span<StringView<>> argv);
+
+int cmd_portread(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_portwrite> = CommandTraits{
+	"portwrite",
+	"portwrite <pin> <value> [<pin> <value> ...]",
+	"Drive several pins HIGH (1) or LOW (0) at the same instant."
+};
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_portread> = CommandTraits{
+	"portread",
+	"portread <pin> [pin ...]",
+	"Sample several pins at the same instant and show their levels in order."
+};
+
+} /* namespace ino */
+
+#endif /* INO_PORTIO_H */
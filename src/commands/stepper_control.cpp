@@ -1,49 +1,196 @@
 #include <Arduino.h>
+#include <avr/interrupt.h>
 #include "commands/stepper_control.h"
 #include "Stepper.h"
+#include "EepromRecord.h"
 #include "ino_assert.h"
 
-static ino::Stepper<100u, 4, 7, 5, 6> stepper;
+// The window position survives resets in the first 64 bytes of EEPROM.
+using WindowMemory = ino::EepromRecord<ino::StepperState, 0u, 16u>;
 
+static ino::Stepper<100u, 4, 7, 5, 6, ino::FullStep, 8u, WindowMemory> stepper;
 
-int ino::cmd_window(Span<StringView<>> argv) {
+static constexpr uint8_t window_closed = 0u;
+static constexpr uint8_t window_opened = 50u;
+
+ISR(TIMER1_COMPA_vect) {
+	stepper.timer_interrupt();
+}
+
+ISR(EE_READY_vect) {
+	stepper.memory().ready_interrupt();
+}
+
+static void stepper_begin() {
 	static bool initialized = false;
 	if(not initialized) {
 		stepper.begin();
 		initialized = true;
 	}
+}
+
+uint8_t ino::window(Switch request) {
+	stepper_begin();
+	// The window always opens forwards and closes backwards, whatever the shorter way is.
+	switch(request) {
+	case Switch::On:
+		stepper.move_to(window_opened, Direction::Forward);
+		break;
+	case Switch::Off:
+		stepper.move_to(window_closed, Direction::Backward);
+		break;
+	case Switch::Query:
+		break;
+	}
+	return stepper.position();
+}
+
+uint8_t ino::window_stop() {
+	stepper_begin();
+	stepper.stop();
+	return stepper.position();
+}
+
+int ino::cmd_window(Span<StringView<>> argv) {
 	switch(argv.size()) {
 	default:
 		return ino::command_error(F("Command 'window' takes at most one argument"));
-	case 1:
-		switch(stepper.position()) {
-		case 0u:
+	case 1: {
+		uint8_t position = window(Switch::Query);
+		if(stepper.moving()) {
+			if(stepper.target() == window_opened) {
+				Serial.print(F("OPENING "));
+			} else {
+				Serial.print(F("CLOSING "));
+			}
+			Serial.println(position);
+		} else if(position == window_closed) {
 			Serial.println(F("CLOSED"));
-			break;
-		case 50u:
+		} else if(position == window_opened) {
 			Serial.println(F("OPENED"));
-			break;
+		} else {
+			Serial.print(F("STOPPED "));
+			Serial.println(position);
 		}
 		return 0;
+	}
 	case 2: 
 		if(argv[1] == "OPEN" or argv[1] == "open") {
-			if(stepper.position() == 0u) {
-				stepper.set_position(25u);
-				stepper.set_position(50u);
-			} else {
-				ASSERT(stepper.position() == 50u);
-			}
+			(void)window(Switch::On);
 			return 0;
 		} else if(argv[1] == "CLOSE" or argv[1] == "close") {
-			if(stepper.position() == 50) {
-				stepper.set_position(25u);
-				stepper.set_position(0u);
-			} else {
-				ASSERT(stepper.position() == 0u);
-			}
+			(void)window(Switch::Off);
+			return 0;
+		} else if(argv[1] == "STOP" or argv[1] == "stop") {
+			(void)window_stop();
 			return 0;
 		} else {
-			return command_error(F("Invalid argument to command 'window'.  Valid values are 'OPEN', 'open', 'CLOSE', or 'close'."));
+			return command_error(F("Invalid argument to command 'window'.  Valid values are 'OPEN', 'open', 'CLOSE', 'close', 'STOP', or 'stop'."));
 		}
 	}
 }
+
+static int stepper_status() {
+	Serial.print(F("POSITION "));
+	Serial.print(stepper.position());
+	Serial.print(F(" TARGET "));
+	Serial.print(stepper.target());
+	Serial.print(F(" QUEUED "));
+	Serial.print(stepper.queued());
+	Serial.print(F(" SPEED "));
+	Serial.println(stepper.cruise_speed());
+	return 0;
+}
+
+static int stepper_list() {
+	uint8_t count = stepper.queued();
+	for(uint8_t i = 0u; i < count; ++i) {
+		ino::StepperMove move = stepper.queued_move(i);
+		Serial.print(i);
+		if(move.direction == ino::Direction::Forward) {
+			Serial.print(F(": FORWARD "));
+		} else {
+			Serial.print(F(": BACKWARD "));
+		}
+		Serial.print(move.steps);
+		Serial.print(F(" @ "));
+		Serial.println(move.speed);
+	}
+	return 0;
+}
+
+int ino::cmd_stepper(Span<StringView<>> argv) {
+	stepper_begin();
+	if(argv.size() == 1u) {
+		return stepper_status();
+	}
+	StringView<> action = argv[1];
+	if(action == "list" or action == "flush" or action == "stop") {
+		if(argv.size() != 2u) {
+			return command_error(F("Command 'stepper "), action, F("' takes no arguments."));
+		}
+		if(action == "list") {
+			return stepper_list();
+		} else if(action == "flush") {
+			stepper.flush();
+		} else {
+			stepper.stop();
+		}
+		return 0;
+	}
+	if(action == "speed") {
+		if(argv.size() != 3u) {
+			return command_error(F("Command 'stepper speed' expects a speed in steps per second."));
+		}
+		Optional<uint16_t> speed = parse_decimal<uint16_t>(argv[2]);
+		if(not speed) {
+			return command_error(F("Cannot parse '"), argv[2], F("' as a speed."));
+		}
+		stepper.set_cruise_speed(*speed);
+		return 0;
+	}
+	if(action != "to" and action != "by") {
+		return command_error(F("Invalid argument to command 'stepper': '"), action, F("'."));
+	}
+	if(argv.size() != 3u and argv.size() != 4u) {
+		return command_error(F("Command 'stepper "), action, F("' expects a distance and an optional speed."));
+	}
+	uint16_t speed = 0u;
+	if(argv.size() == 4u) {
+		Optional<uint16_t> value = parse_decimal<uint16_t>(argv[3]);
+		if(not value or *value == 0u) {
+			return command_error(F("Cannot parse '"), argv[3], F("' as a speed."));
+		}
+		speed = *value;
+	}
+	// Moves stay within the window's travel, so that window() can open forwards and close
+	// backwards from wherever the stepper is left.
+	int16_t from = stepper.planned_position();
+	int16_t to = 0;
+	if(action == "to") {
+		Optional<uint8_t> position = parse_decimal<uint8_t>(argv[2]);
+		if(not position or *position > window_opened) {
+			return command_error(F("Invalid stepper position '"), argv[2], F("' (must be in the range [0, "), window_opened, F("])."));
+		}
+		to = *position;
+	} else {
+		Optional<int16_t> steps = parse_decimal<int16_t>(argv[2]);
+		// Bound the count first: on AVR an int is 16 bits, so 'from + *steps' could overflow.
+		if(not steps or *steps < -int16_t(window_opened) or *steps > int16_t(window_opened)
+			or from + *steps < window_closed or from + *steps > window_opened)
+		{
+			return command_error(F("Invalid step count '"), argv[2], F("' (must keep the position in the range [0, "), window_opened, F("])."));
+		}
+		to = from + *steps;
+	}
+	bool queued = true;
+	if(to > from) {
+		queued = stepper.enqueue(Direction::Forward, static_cast<uint8_t>(to - from), speed);
+	} else if(to < from) {
+		queued = stepper.enqueue(Direction::Backward, static_cast<uint8_t>(from - to), speed);
+	}
+	if(not queued) {
+		return command_error(F("The stepper move queue is full."));
+	}
+	return 0;
+}
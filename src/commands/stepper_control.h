@@ -6,12 +6,33 @@ namespace ino {
 
 int cmd_window(Span<StringView<>>);
 
+/**
+ * Start opening (Switch::On) or closing (Switch::Off) the window and return the current
+ * stepper position.  The window keeps moving in the background after this returns.
+ */
+uint8_t window(Switch request);
+
+/** Stop the window wherever it is and return the stepper position. */
+uint8_t window_stop();
+
+int cmd_stepper(Span<StringView<>>);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_stepper> = ino::CommandTraits{
+	"stepper",
+	"stepper [to <position> [speed] | by <steps> [speed] | speed <speed> | list | flush | stop]",
+	"Show the stepper state, queue a move to a position or by a number of steps (staying "
+	"within the window's travel, 0 to 50), set the default speed (steps/s), list or drop "
+	"queued moves, or stop."
+};
+
 template <>
 [[gnu::progmem]]
 inline constexpr auto command_traits<cmd_window> = ino::CommandTraits{
 	"window",
-	"window [OPEN/CLOSE]",
-	"Get or set the window position."
+	"window [OPEN/CLOSE/STOP]",
+	"Get the window position, or start opening, closing, or stop it."
 };
 
 } /* namespace ino */
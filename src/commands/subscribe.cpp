@@ -0,0 +1,114 @@
+#include "commands/subscribe.h"
+#include "Subscriptions.h"
+
+namespace ino {
+
+static void print_source(TelemetrySource source) {
+	switch(source) {
+	case TelemetrySource::AnalogRead:
+		Serial.print(F("analogread"));
+		break;
+	case TelemetrySource::DigitalRead:
+		Serial.print(F("digitalread"));
+		break;
+	case TelemetrySource::CheckengineStatus:
+		Serial.print(F("checkengine_status"));
+		break;
+	case TelemetrySource::Window:
+		Serial.print(F("window"));
+		break;
+	case TelemetrySource::AnalogFiltered:
+		Serial.print(F("analogread"));
+		break;
+	}
+}
+
+static int list_subscriptions() {
+	for(uint8_t id = 0u; id < max_subscriptions; ++id) {
+		const Subscription* sub = find_subscription(id);
+		if(not sub) {
+			continue;
+		}
+		Serial.print(id);
+		Serial.print(' ');
+		print_source(sub->source);
+		if(sub->source == TelemetrySource::AnalogRead or sub->source == TelemetrySource::DigitalRead
+			or sub->source == TelemetrySource::AnalogFiltered)
+		{
+			Serial.print(' ');
+			Serial.print(all_pins[sub->pin].name());
+		}
+		if(sub->source == TelemetrySource::AnalogFiltered) {
+			Serial.print(F(" filtered"));
+		}
+		Serial.print(' ');
+		Serial.println(sub->period);
+	}
+	return 0;
+}
+
+int cmd_subscribe(Span<StringView<>> argv) {
+	if(argv.size() == 1u) {
+		return list_subscriptions();
+	}
+	TelemetrySource source;
+	bool takes_pin = false;
+	if(argv[1] == "analogread") {
+		source = TelemetrySource::AnalogRead;
+		takes_pin = true;
+	} else if(argv[1] == "digitalread") {
+		source = TelemetrySource::DigitalRead;
+		takes_pin = true;
+	} else if(argv[1] == "checkengine_status") {
+		source = TelemetrySource::CheckengineStatus;
+	} else if(argv[1] == "window") {
+		source = TelemetrySource::Window;
+	} else {
+		return command_error(F("Cannot subscribe to '"), argv[1], F("'.  Valid commands are 'analogread', 'digitalread', 'checkengine_status', or 'window'."));
+	}
+	std::size_t expected = takes_pin ? 4u : 3u;
+	if(source == TelemetrySource::AnalogRead and argv.size() == 5u and (argv[3] == "filtered" or argv[3] == "FILTERED")) {
+		source = TelemetrySource::AnalogFiltered;
+		expected = 5u;
+	}
+	if(argv.size() != expected) {
+		return command_error(F("Expected 'subscribe "), argv[1], takes_pin ? F(" <pin> <period_ms>'.") : F(" <period_ms>'."));
+	}
+	const CheckedPin* pin = nullptr;
+	if(takes_pin) {
+		pin = pin_from_name(argv[2]);
+		if(not pin) {
+			return command_error(F("Invalid pin name '"), argv[2], F("'."));
+		} else if(source != TelemetrySource::DigitalRead and pin->kind() != PinKind::Analog) {
+			return command_error(F("Pin "), argv[2], F(" is not an analog pin."));
+		}
+	}
+	Optional<uint16_t> period = parse_decimal<uint16_t>(argv[expected - 1u]);
+	if(not period or *period == 0u) {
+		return command_error(F("Invalid period '"), argv[expected - 1u], F("' (must be in the range [1, 65535])."));
+	}
+	int8_t id = subscribe(source, pin, *period);
+	if(id < 0) {
+		return command_error(F("All subscriptions are taken."));
+	}
+	return command_success(id);
+}
+
+int cmd_unsubscribe(Span<StringView<>> argv) {
+	switch(argv.size()) {
+	default:
+		return command_error(F("Command 'unsubscribe' takes at most 1 argument."));
+	case 1:
+		unsubscribe_all();
+		return 0;
+	case 2:
+		break;
+	}
+	Optional<uint8_t> id = parse_decimal<uint8_t>(argv[1]);
+	if(not id or not unsubscribe(*id)) {
+		return command_error(F("No subscription with ID '"), argv[1], F("'."));
+	}
+	return 0;
+}
+
+} /* namespace ino */
@@ -0,0 +1,31 @@
+#ifndef INO_SUBSCRIBE_H
+#define INO_SUBSCRIBE_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_subscribe(Span<StringView<>> argv);
+
+int cmd_unsubscribe(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_subscribe> = CommandTraits{
+	"subscribe",
+	"subscribe [<command> [pin] [filtered] <period_ms>]",
+	"Run analogread, digitalread, checkengine_status or window every period and report "
+	"'!SUB <id>=<value> ...' lines, or list the subscriptions.  'filtered' applies to analogread."
+};
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_unsubscribe> = CommandTraits{
+	"unsubscribe",
+	"unsubscribe [id]",
+	"Cancel a subscription, or all of them."
+};
+
+} /* namespace ino */
+
+#endif /* INO_SUBSCRIBE_H */
@@ -0,0 +1,46 @@
+#include "commands/watch.h"
+#include "PinEvents.h"
+
+namespace ino {
+
+int cmd_watch(Span<StringView<>> argv) {
+	if(argv.size() == 1u) {
+		bool first = true;
+		for(const CheckedPin& pin: all_pins) {
+			if(pin_watched(static_cast<uint8_t>(pin.index()))) {
+				if(not first) {
+					Serial.print(' ');
+				}
+				Serial.print(pin.name());
+				first = false;
+			}
+		}
+		Serial.println();
+		return 0;
+	}
+	const auto* pin = pincommand_check(argv, 2);
+	if(not pin) {
+		return -1;
+	}
+	if(watch_pin(*pin) != PinStatus::Good) {
+		return command_error(F("Pin "), argv[1], F(" is used by the serial port."));
+	}
+	return 0;
+}
+
+int cmd_unwatch(Span<StringView<>> argv) {
+	if(argv.size() == 1u) {
+		for(const CheckedPin& pin: all_pins) {
+			unwatch_pin(pin);
+		}
+		return 0;
+	}
+	const auto* pin = pincommand_check(argv, 2);
+	if(not pin) {
+		return -1;
+	}
+	unwatch_pin(*pin);
+	return 0;
+}
+
+} /* namespace ino */
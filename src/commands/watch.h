@@ -0,0 +1,30 @@
+#ifndef INO_WATCH_H
+#define INO_WATCH_H
+
+#include "Command.h"
+
+namespace ino {
+
+int cmd_watch(Span<StringView<>> argv);
+
+int cmd_unwatch(Span<StringView<>> argv);
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_watch> = CommandTraits{
+	"watch",
+	"watch [pin]",
+	"Report changes of the pin as '!PIN <pin> <level> <millis>' lines, or list the watched pins."
+};
+
+template <>
+[[gnu::progmem]]
+inline constexpr auto command_traits<cmd_unwatch> = CommandTraits{
+	"unwatch",
+	"unwatch [pin]",
+	"Stop reporting changes of the pin, or of every pin."
+};
+
+} /* namespace ino */
+
+#endif /* INO_WATCH_H */
@@ -1,8 +1,14 @@
 #include <Arduino.h>
 
 #include "Pins.h"
+#include "Adc.h"
 #include "Command.h"
 #include "command_parsing.h"
+#include "BinaryCommand.h"
+#include "PinEvents.h"
+#include "Notifications.h"
+#include "Subscriptions.h"
+#include "AnalogComparator.h"
 #include "commands/checkengine.h"
 
 
@@ -30,28 +36,115 @@ void setup()
 	ino::pin<A5>.set_mode(ino::PinMode::Input);
 	ino::pin<A6>.set_mode(ino::PinMode::Input);
 	ino::pin<A7>.set_mode(ino::PinMode::Input);
+	ino::adc_start_scan();
+	ino::checkengine_begin();
 	attachInterrupt(0, ino::checkengine_interrupt, CHANGE);
 }
 
-// Buffer to read lines from serial into.
-static char line_buffer[128] = "";
+// Reads lines from serial, in place in the receive buffer.
+static ino::LineReader line_reader;
 // Buffer to store tokens in when tokenizing lines.
-static ino::StringView<> token_buffer[10] = {{}};
+static ino::StringView<> token_buffer[16] = {{}};
+// Reads binary protocol frames from serial.
+static ino::FrameReader<ino::max_frame_length> frame_reader;
+// Whether the text prompt should be printed before reading the next line.
+static bool prompt_pending = true;
 
-void loop()
+static void serve_binary_frame()
 {
-	Serial.print("ino> ");
-	auto line_length = ino::read_line(Serial, line_buffer);
-	if(line_length < 0) {
-		Serial.println("Error: Command too long.");
+	switch(frame_reader.poll(Serial)) {
+	case ino::ReadStatus::Incomplete:
+		return;
+	case ino::ReadStatus::Overflow:
+		ino::write_frame(Serial, ino::FrameStatus::FrameTooLong);
+		return;
+	case ino::ReadStatus::BadChecksum:
+		ino::write_frame(Serial, ino::FrameStatus::BadChecksum);
 		return;
+	case ino::ReadStatus::Complete:
+		ino::invoke_binary_command(frame_reader.frame());
+		return;
+	}
+}
+
+static void serve_text_line()
+{
+	if(prompt_pending) {
+		Serial.print("ino> ");
+		prompt_pending = false;
 	}
-	int count = ino::tokenize_line(token_buffer, ino::StringView<>(line_buffer, line_length));
-	if(count < 0) {
-		Serial.println("Error: Too many tokens in command.");
+	switch(line_reader.poll(Serial)) {
+	case ino::ReadStatus::Incomplete:
+	case ino::ReadStatus::BadChecksum:
 		return;
+	case ino::ReadStatus::Overflow:
+		Serial.println("Error: Command too long.");
+		break;
+	case ino::ReadStatus::Complete:
+		if(int count = ino::tokenize_line(token_buffer, line_reader.line()); count < 0) {
+			Serial.println("Error: Too many tokens in command.");
+		} else {
+			int err = ino::invoke_command(ino::Span(token_buffer, count));
+			(void)err;
+		}
+		// The tokens point into the receive buffer; hand the space back.
+		line_reader.release(Serial);
+		break;
+	}
+	prompt_pending = true;
+}
+
+// Finish the line holding a prompt, so that a notification gets a line of its own.
+static void interrupt_prompt()
+{
+	if(ino::active_protocol() == ino::Protocol::Text and not prompt_pending) {
+		Serial.println();
+		prompt_pending = true;
+	}
+}
+
+static void handle_pin_events()
+{
+	ino::PinEvent event;
+	while(ino::poll_pin_event(event)) {
+		ino::checkengine_pin_event(event);
+		if(ino::pin_watched(event.pin)) {
+			interrupt_prompt();
+			ino::notify_pin_change(event);
+		}
+	}
+}
+
+static void handle_comparator_events()
+{
+	ino::ComparatorEvent event;
+	while(ino::poll_comparator_event(event)) {
+		interrupt_prompt();
+		ino::notify_comparator(event);
+	}
+}
+
+static void handle_subscriptions()
+{
+	ino::TelemetrySample samples[ino::max_subscriptions];
+	if(uint8_t count = ino::sample_subscriptions(ino::Span(samples, ino::max_subscriptions)); count != 0u) {
+		interrupt_prompt();
+		ino::notify_telemetry(ino::Span<const ino::TelemetrySample>(samples, count));
+	}
+}
+
+void loop()
+{
+	handle_pin_events();
+	handle_comparator_events();
+	handle_subscriptions();
+	// Neither of these wait for input, so anything else that needs to run
+	// periodically can be done here as well.
+	if(ino::active_protocol() == ino::Protocol::Binary) {
+		serve_binary_frame();
+	} else {
+		serve_text_line();
 	}
-	int err = ino::invoke_command(ino::Span(token_buffer, count));
 }
 
 int main(void)